@@ -0,0 +1,49 @@
+#pragma once
+
+//Lanes of the AVX2 kernels, see PixelKernelImpl.h and VertexKernelImpl.h for how they are used
+//Only include this in the translation units compiled with AVX2 enabled (/arch:AVX2), like PixelKernelAVX2.cpp and VertexKernelAVX2.cpp
+//Call those kernels only when PixelKernel::IsSupported says so, and end them with _mm256_zeroupper
+
+#include <cstdint>
+#include <immintrin.h>
+
+namespace dae
+{
+	namespace
+	{
+		struct AVX2Lanes
+		{
+			using Float = __m256;
+			static constexpr int count{ 8 };
+
+			static Float Set1(const float value) { return _mm256_set1_ps(value); }
+			static Float LaneIndex() { return _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f); }
+			static Float Load(const float* pValues) { return _mm256_loadu_ps(pValues); }
+			static Float LoadUnsigned16(const uint16_t* pValues) { return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pValues)))); }
+			static Float LoadSigned16(const int16_t* pValues) { return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pValues)))); }
+			static void Store(float* pValues, const Float value) { _mm256_storeu_ps(pValues, value); }
+
+			static Float Add(const Float a, const Float b) { return _mm256_add_ps(a, b); }
+			static Float Sub(const Float a, const Float b) { return _mm256_sub_ps(a, b); }
+			static Float Mul(const Float a, const Float b) { return _mm256_mul_ps(a, b); }
+			static Float Div(const Float a, const Float b) { return _mm256_div_ps(a, b); }
+			static Float Sqrt(const Float a) { return _mm256_sqrt_ps(a); }
+			static Float ReciprocalEstimate(const Float a) { return _mm256_rcp_ps(a); }
+			static Float RsqrtEstimate(const Float a) { return _mm256_rsqrt_ps(a); }
+			static Float Abs(const Float a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+			static Float Max(const Float a, const Float b) { return _mm256_max_ps(a, b); }
+			static Float CopySign(const Float magnitude, const Float sign)
+			{
+				const Float signBit{ _mm256_set1_ps(-0.0f) };
+				return _mm256_or_ps(_mm256_andnot_ps(signBit, magnitude), _mm256_and_ps(signBit, sign));
+			}
+
+			static Float Less(const Float a, const Float b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+			static Float Greater(const Float a, const Float b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+			static Float GreaterEqual(const Float a, const Float b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+
+			static Float Or(const Float a, const Float b) { return _mm256_or_ps(a, b); }
+			static int MoveMask(const Float a) { return _mm256_movemask_ps(a); }
+		};
+	}
+}
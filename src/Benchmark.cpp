@@ -0,0 +1,108 @@
+//Project includes
+#include "Benchmark.h"
+#include "Renderer.h"
+
+#include <fstream>
+#include <iostream>
+
+using namespace dae;
+
+namespace
+{
+	struct BenchmarkScene
+	{
+		const char* name;
+		RenderAssets assets;
+	};
+
+	struct BenchmarkResolution
+	{
+		int width;
+		int height;
+	};
+
+	//Radians per frame, so every run renders the same frames
+	constexpr float g_RotationStep{ 0.02f };
+}
+
+int dae::RunBenchmark(const BenchmarkSettings& settings)
+{
+	//The tuktuk only has a diffuse map, it shows the cost of the shading without the other maps
+	const BenchmarkScene scenes[]
+	{
+		{ "vehicle", RenderAssets{} },
+		{ "tuktuk", RenderAssets{ "Resources/tuktuk.obj", "Resources/tuktuk.png", "", "", "" } }
+	};
+	const BenchmarkResolution resolutions[]
+	{
+		{ 640, 480 },
+		{ 1280, 720 },
+		{ 1920, 1080 }
+	};
+
+	std::ofstream file{ settings.outputPath };
+	if (!file)
+	{
+		std::cout << "Could not open " << settings.outputPath << std::endl;
+		return 1;
+	}
+
+	file << "{\n";
+	file << "\t\"frames\": " << settings.nrFrames << ",\n";
+	file << "\t\"warmupFrames\": " << settings.nrWarmupFrames << ",\n";
+	file << "\t\"pixelKernel\": \"" << PixelKernel::GetName(PixelKernel::GetBestSupported()) << "\",\n";
+	file << "\t\"runs\": [\n";
+
+	bool isFirstRun{ true };
+	for (const BenchmarkScene& scene : scenes)
+	{
+		for (const BenchmarkResolution& resolution : resolutions)
+		{
+			Renderer renderer{ resolution.width, resolution.height, scene.assets };
+
+			//Combined shading with the normal map, the most expensive mode
+			renderer.SetShadingMode(ShadingMode::Combined);
+			renderer.SetDisplayNormalMap(true);
+
+			//Every measured frame renders all the tiles
+			renderer.SetFrameReuse(false);
+
+			FrameProfiler& profiler{ renderer.GetProfiler() };
+			profiler.SetMaxFrames(settings.nrFrames);
+			profiler.SetEnabled(true);
+
+			int frame{ 0 };
+			for (; frame < settings.nrWarmupFrames; ++frame)
+			{
+				renderer.SetMeshRotation(frame * g_RotationStep);
+				renderer.Render();
+			}
+			profiler.Reset();
+
+			for (int measuredFrame{ 0 }; measuredFrame < settings.nrFrames; ++measuredFrame, ++frame)
+			{
+				renderer.SetMeshRotation(frame * g_RotationStep);
+				renderer.Render();
+			}
+
+			std::cout << scene.name << " " << resolution.width << "x" << resolution.height << std::endl;
+			profiler.PrintReport(std::cout);
+
+			if (!isFirstRun) file << ",\n";
+			isFirstRun = false;
+
+			file << "\t\t{\n";
+			file << "\t\t\t\"scene\": \"" << scene.name << "\",\n";
+			file << "\t\t\t\"width\": " << resolution.width << ",\n";
+			file << "\t\t\t\"height\": " << resolution.height << ",\n";
+			file << "\t\t\t\"profile\": ";
+			profiler.WriteJson(file, "\t\t\t");
+			file << "\n\t\t}";
+		}
+	}
+
+	file << "\n\t]\n}\n";
+
+	std::cout << "Benchmark written to " << settings.outputPath << std::endl;
+	return file.good() ? 0 : 1;
+}
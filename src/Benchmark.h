@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+
+namespace dae
+{
+	//Renders fixed scenes at several resolutions with the profiler enabled
+	//and writes the stage times and counters of every run to a json file
+	struct BenchmarkSettings
+	{
+		int nrFrames{ 100 }; //Measured frames per run
+		int nrWarmupFrames{ 10 }; //Rendered before measuring, so caches and threads are warm
+		std::string outputPath{ "benchmark.json" };
+	};
+
+	//Returns the exit code of the program
+	int RunBenchmark(const BenchmarkSettings& settings);
+}
@@ -0,0 +1,254 @@
+//Project includes
+#include "BoundingVolumeHierarchy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+using namespace dae;
+
+namespace
+{
+	//Distance the boxes have to be outside of a plane before they are culled
+	//Covers the rounding difference with the vertex kernel, which tests the transformed vertices
+	constexpr float g_CullingMargin{ 1e-3f };
+
+	enum struct PlaneSide
+	{
+		Outside,
+		Inside,
+		Crossing
+	};
+
+	PlaneSide GetPlaneSide(const Vector4& plane, const BoundingBox& box)
+	{
+		//Corners of the box the furthest along and against the normal
+		const Vector3 normal{ plane.x, plane.y, plane.z };
+		const Vector3 center{ box.GetCenter() };
+		const Vector3 halfSize{ box.GetSize() * 0.5f };
+		const float distance{ Vector3::Dot(normal, center) + plane.w };
+		const float radius{ std::abs(normal.x) * halfSize.x + std::abs(normal.y) * halfSize.y + std::abs(normal.z) * halfSize.z };
+
+		if (distance + radius < -g_CullingMargin) return PlaneSide::Outside;
+		if (distance - radius >= 0) return PlaneSide::Inside;
+		return PlaneSide::Crossing;
+	}
+}
+
+bool BoundingBox::IsEmpty() const
+{
+	return min.x > max.x || min.y > max.y || min.z > max.z;
+}
+
+void BoundingBox::Add(const Vector3& point)
+{
+	min = { std::min(min.x, point.x), std::min(min.y, point.y), std::min(min.z, point.z) };
+	max = { std::max(max.x, point.x), std::max(max.y, point.y), std::max(max.z, point.z) };
+}
+
+void BoundingBox::Add(const BoundingBox& other)
+{
+	if (other.IsEmpty()) return;
+	Add(other.min);
+	Add(other.max);
+}
+
+Vector3 BoundingBox::GetCenter() const
+{
+	return (min + max) * 0.5f;
+}
+
+Vector3 BoundingBox::GetSize() const
+{
+	return max - min;
+}
+
+BoundingBox BoundingBox::Transform(const BoundingBox& box, const Matrix& matrix)
+{
+	if (box.IsEmpty()) return box;
+
+	//Every axis of the matrix moves the new min and max by its smallest and largest product, see Arvo in Graphics Gems
+	const Vector3 translation{ matrix.GetTranslation() };
+	BoundingBox transformed{ translation, translation };
+	for (int row{ 0 }; row < 3; ++row)
+	{
+		for (int column{ 0 }; column < 3; ++column)
+		{
+			const float a{ matrix[row][column] * box.min[row] };
+			const float b{ matrix[row][column] * box.max[row] };
+			transformed.min[column] += std::min(a, b);
+			transformed.max[column] += std::max(a, b);
+		}
+	}
+	return transformed;
+}
+
+Frustum Frustum::FromViewProjection(const Matrix& viewProjectionMatrix)
+{
+	//Clip space component c of a point is dot(point, column c), the same planes as Clipper::GetOutsidePlanes
+	const auto column = [&viewProjectionMatrix](const int index) -> Vector4
+		{
+			return { viewProjectionMatrix[0][index], viewProjectionMatrix[1][index], viewProjectionMatrix[2][index], viewProjectionMatrix[3][index] };
+		};
+	const Vector4 x{ column(0) };
+	const Vector4 y{ column(1) };
+	const Vector4 z{ column(2) };
+	const Vector4 w{ column(3) };
+
+	Frustum frustum{};
+	frustum.planes[0] = w + x; //Left
+	frustum.planes[1] = w - x; //Right
+	frustum.planes[2] = w + y; //Bottom
+	frustum.planes[3] = w - y; //Top
+	frustum.planes[4] = z; //Near, z >= 0
+	frustum.planes[5] = w - z; //Far
+
+	for (Vector4& plane : frustum.planes)
+	{
+		const float length{ Vector3{ plane.x, plane.y, plane.z }.Magnitude() };
+		plane = { plane.x / length, plane.y / length, plane.z / length, plane.w / length };
+	}
+	return frustum;
+}
+
+bool Frustum::IsOutside(const BoundingBox& box) const
+{
+	if (box.IsEmpty()) return true;
+	return std::any_of(std::begin(planes), std::end(planes), [&box](const Vector4& plane) { return GetPlaneSide(plane, box) == PlaneSide::Outside; });
+}
+
+void BoundingVolumeHierarchy::Build(const std::span<const BoundingBox> itemBoxes)
+{
+	m_Nodes.clear();
+	m_Items.resize(itemBoxes.size());
+	std::iota(m_Items.begin(), m_Items.end(), 0u);
+	if (itemBoxes.empty()) return;
+
+	//At most 2n - 1 nodes
+	m_Nodes.reserve(2 * itemBoxes.size());
+	m_Nodes.emplace_back();
+	BuildNode(0, 0, static_cast<uint32_t>(itemBoxes.size()), itemBoxes, 0);
+}
+
+void BoundingVolumeHierarchy::Refit(const std::span<const BoundingBox> itemBoxes)
+{
+	//Backwards, so the children are done before their parent
+	for (size_t nodeIndex{ m_Nodes.size() }; nodeIndex-- > 0;)
+	{
+		Node& node{ m_Nodes[nodeIndex] };
+		node.box = BoundingBox{};
+		if (node.count)
+		{
+			for (uint32_t i{ node.first }; i < node.first + node.count; ++i)
+			{
+				node.box.Add(itemBoxes[m_Items[i]]);
+			}
+		}
+		else
+		{
+			node.box.Add(m_Nodes[node.first].box);
+			node.box.Add(m_Nodes[node.first + 1].box);
+		}
+	}
+}
+
+size_t BoundingVolumeHierarchy::Cull(const Frustum& frustum, const std::span<const BoundingBox> itemBoxes, const std::span<uint8_t> isVisible) const
+{
+	std::fill(isVisible.begin(), isVisible.end(), uint8_t{ 0 });
+	if (m_Nodes.empty()) return 0;
+
+	//The planes a node still has to be tested against, its parent was inside of the other ones
+	constexpr uint8_t allPlanes{ (1 << 6) - 1 };
+	struct StackEntry
+	{
+		uint32_t node{};
+		uint8_t planeMask{};
+	};
+	StackEntry stack[m_MaxDepth + 2]{};
+	int stackSize{ 0 };
+	stack[stackSize++] = { 0, allPlanes };
+
+	//Tests the box against the planes of the mask, removes the planes it is inside of, false when it is outside
+	const auto testBox = [&frustum](const BoundingBox& box, uint8_t& planeMask)
+		{
+			if (box.IsEmpty()) return false;
+			for (int plane{ 0 }; plane < 6; ++plane)
+			{
+				if (!(planeMask & (1 << plane))) continue;
+
+				const PlaneSide side{ GetPlaneSide(frustum.planes[plane], box) };
+				if (side == PlaneSide::Outside) return false;
+				if (side == PlaneSide::Inside) planeMask &= ~(1 << plane);
+			}
+			return true;
+		};
+
+	size_t nrVisible{ 0 };
+	while (stackSize > 0)
+	{
+		StackEntry entry{ stack[--stackSize] };
+		const Node& node{ m_Nodes[entry.node] };
+		if (!testBox(node.box, entry.planeMask)) continue;
+
+		if (!node.count)
+		{
+			stack[stackSize++] = { node.first + 1, entry.planeMask };
+			stack[stackSize++] = { node.first, entry.planeMask };
+			continue;
+		}
+
+		//The boxes of the items are smaller than the one of their leaf, unless the leaf is fully inside
+		for (uint32_t i{ node.first }; i < node.first + node.count; ++i)
+		{
+			const uint32_t item{ m_Items[i] };
+			uint8_t itemPlaneMask{ entry.planeMask };
+			if (testBox(itemBoxes[item], itemPlaneMask))
+			{
+				isVisible[item] = 1;
+				++nrVisible;
+			}
+		}
+	}
+	return nrVisible;
+}
+
+size_t BoundingVolumeHierarchy::GetNrItems() const
+{
+	return m_Items.size();
+}
+
+void BoundingVolumeHierarchy::BuildNode(const uint32_t nodeIndex, const uint32_t first, const uint32_t count, const std::span<const BoundingBox> itemBoxes, const int depth)
+{
+	BoundingBox box{};
+	BoundingBox centers{};
+	for (uint32_t i{ first }; i < first + count; ++i)
+	{
+		box.Add(itemBoxes[m_Items[i]]);
+		centers.Add(itemBoxes[m_Items[i]].GetCenter());
+	}
+	m_Nodes[nodeIndex].box = box;
+
+	//The depth limit keeps the culling stack small, that leaf has more items
+	if (count <= m_MaxLeafSize || depth == m_MaxDepth)
+	{
+		m_Nodes[nodeIndex].first = first;
+		m_Nodes[nodeIndex].count = count;
+		return;
+	}
+
+	//Median of the longest axis of the centers, both halves get the same number of items
+	const Vector3 size{ centers.GetSize() };
+	const int axis{ size.x >= size.y && size.x >= size.z ? 0 : (size.y >= size.z ? 1 : 2) };
+	const uint32_t half{ count / 2 };
+	std::nth_element(m_Items.begin() + first, m_Items.begin() + first + half, m_Items.begin() + first + count,
+		[&itemBoxes, axis](const uint32_t a, const uint32_t b) { return itemBoxes[a].GetCenter()[axis] < itemBoxes[b].GetCenter()[axis]; });
+
+	//Both children next to each other, after their parent
+	const uint32_t firstChild{ static_cast<uint32_t>(m_Nodes.size()) };
+	m_Nodes[nodeIndex].first = firstChild;
+	m_Nodes[nodeIndex].count = 0;
+	m_Nodes.emplace_back();
+	m_Nodes.emplace_back();
+	BuildNode(firstChild, first, half, itemBoxes, depth + 1);
+	BuildNode(firstChild + 1, first + half, count - half, itemBoxes, depth + 1);
+}
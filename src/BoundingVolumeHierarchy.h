@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cfloat>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "DataTypes.h"
+
+namespace dae
+{
+	//Axis aligned box, empty while min > max
+	struct BoundingBox
+	{
+		Vector3 min{ FLT_MAX, FLT_MAX, FLT_MAX };
+		Vector3 max{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+		bool IsEmpty() const;
+		void Add(const Vector3& point);
+		void Add(const BoundingBox& other);
+		Vector3 GetCenter() const;
+		Vector3 GetSize() const;
+
+		//Box around the transformed box, a bit larger than the transformed content when it is rotated
+		static BoundingBox Transform(const BoundingBox& box, const Matrix& matrix);
+	};
+
+	//The 6 planes of the view frustum in world space, from the view projection matrix
+	struct Frustum
+	{
+		//Normalized, positive inside, distance = dot(normal, point) + w
+		Vector4 planes[6]{};
+
+		static Frustum FromViewProjection(const Matrix& viewProjectionMatrix);
+
+		//Only true when every point of the box is outside of the same plane, so none of its triangles can be seen
+		bool IsOutside(const BoundingBox& box) const;
+	};
+
+	//Hierarchy of boxes over the instances of a scene, to cull whole groups of instances at once
+	//Built once, then refit when the instances move, the tree itself only changes when instances are added
+	class BoundingVolumeHierarchy final
+	{
+	public:
+		//Top down, every node is split at the median of its longest axis
+		void Build(std::span<const BoundingBox> itemBoxes);
+		//Same tree, the nodes grow or shrink to the new boxes of the items
+		void Refit(std::span<const BoundingBox> itemBoxes);
+
+		//Sets isVisible to 1 for the items whose box isn't outside of the frustum, 0 for the others
+		//Returns the number of visible items
+		size_t Cull(const Frustum& frustum, std::span<const BoundingBox> itemBoxes, std::span<uint8_t> isVisible) const;
+
+		size_t GetNrItems() const;
+
+	private:
+		static constexpr uint32_t m_MaxLeafSize{ 4 };
+		static constexpr int m_MaxDepth{ 64 };
+
+		struct Node
+		{
+			BoundingBox box{};
+			uint32_t first{}; //First item of a leaf, or the first of the two children
+			uint32_t count{}; //Items of a leaf, 0 for the other nodes
+		};
+
+		void BuildNode(uint32_t nodeIndex, uint32_t first, uint32_t count, std::span<const BoundingBox> itemBoxes, int depth);
+
+		//Children are always after their parent
+		std::vector<Node> m_Nodes{};
+		std::vector<uint32_t> m_Items{}; //Item indices in leaf order
+	};
+}
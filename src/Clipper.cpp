@@ -0,0 +1,116 @@
+//Project includes
+#include "Clipper.h"
+
+#include <algorithm>
+
+namespace dae
+{
+	namespace
+	{
+		//Signed distance to a clipping plane, positive on the visible side
+		using PlaneDistance = float(*)(const Vector4& position);
+
+		float NearDistance(const Vector4& position) { return position.z; }
+		float GuardLeftDistance(const Vector4& position) { return position.x + Clipper::guardBand * position.w; }
+		float GuardRightDistance(const Vector4& position) { return Clipper::guardBand * position.w - position.x; }
+		float GuardBottomDistance(const Vector4& position) { return position.y + Clipper::guardBand * position.w; }
+		float GuardTopDistance(const Vector4& position) { return Clipper::guardBand * position.w - position.y; }
+
+		Vertex_Out LerpVertex(const Vertex_Out& from, const Vertex_Out& to, const float t)
+		{
+			const float s{ 1 - t };
+			return Vertex_Out
+			{
+				from.position * s + to.position * t,
+				from.color * s + to.color * t,
+				from.uv * s + to.uv * t,
+				from.normal * s + to.normal * t,
+				from.tangent * s + to.tangent * t,
+				from.viewDirection * s + to.viewDirection * t
+			};
+		}
+
+		//Sutherland-Hodgman against one plane, returns the new number of vertices
+		int ClipAgainstPlane(const Vertex_Out* pInput, const int nrInput, const PlaneDistance distance, Vertex_Out* pOutput)
+		{
+			int nrOutput{ 0 };
+			for (int i{ 0 }; i < nrInput; ++i)
+			{
+				const Vertex_Out& current{ pInput[i] };
+				const Vertex_Out& next{ pInput[(i + 1) % nrInput] };
+				const float currentDistance{ distance(current.position) };
+				const float nextDistance{ distance(next.position) };
+
+				if (currentDistance >= 0) pOutput[nrOutput++] = current;
+
+				//The edge crosses the plane, keep the intersection
+				if ((currentDistance >= 0) != (nextDistance >= 0))
+				{
+					const float t{ currentDistance / (currentDistance - nextDistance) };
+					pOutput[nrOutput++] = LerpVertex(current, next, t);
+				}
+			}
+			return nrOutput;
+		}
+	}
+
+	uint8_t Clipper::GetOutsidePlanes(const Vector4& position)
+	{
+		const float guardW{ guardBand * position.w };
+
+		uint8_t outsidePlanes{};
+		if (position.x < -position.w) outsidePlanes |= outsideLeft;
+		if (position.x > position.w) outsidePlanes |= outsideRight;
+		if (position.y < -position.w) outsidePlanes |= outsideBottom;
+		if (position.y > position.w) outsidePlanes |= outsideTop;
+		if (position.z < 0) outsidePlanes |= outsideNear;
+		if (position.z > position.w) outsidePlanes |= outsideFar;
+		if (position.x < -guardW || position.x > guardW || position.y < -guardW || position.y > guardW) outsidePlanes |= outsideGuardBand;
+		return outsidePlanes;
+	}
+
+	float Clipper::GetWinding(const Vector4& p0, const Vector4& p1, const Vector4& p2)
+	{
+		//Determinant of the (x, y, w) rows, it has the sign of the ndc area times the signs of the w values
+		return p0.x * (p1.y * p2.w - p1.w * p2.y)
+			- p0.y * (p1.x * p2.w - p1.w * p2.x)
+			+ p0.w * (p1.x * p2.y - p1.y * p2.x);
+	}
+
+	int Clipper::ClipTriangle(const Vertex_Out* pTriangle[3], const uint8_t outsidePlanes, Vertex_Out* pPolygon)
+	{
+		Vertex_Out buffer[maxPolygonSize]{};
+
+		int nrVertices{ 3 };
+		for (int i{ 0 }; i < 3; ++i)
+		{
+			pPolygon[i] = *pTriangle[i];
+		}
+
+		PlaneDistance planes[5]{};
+		int nrPlanes{ 0 };
+		if (outsidePlanes & outsideNear) planes[nrPlanes++] = NearDistance;
+		if (outsidePlanes & outsideGuardBand)
+		{
+			planes[nrPlanes++] = GuardLeftDistance;
+			planes[nrPlanes++] = GuardRightDistance;
+			planes[nrPlanes++] = GuardBottomDistance;
+			planes[nrPlanes++] = GuardTopDistance;
+		}
+
+		//Ping pong between the polygon and the buffer, every plane adds at most one vertex
+		Vertex_Out* pInput{ pPolygon };
+		Vertex_Out* pOutput{ buffer };
+		for (int plane{ 0 }; plane < nrPlanes && nrVertices >= 3; ++plane)
+		{
+			nrVertices = ClipAgainstPlane(pInput, nrVertices, planes[plane], pOutput);
+			std::swap(pInput, pOutput);
+		}
+
+		if (pInput != pPolygon)
+		{
+			std::copy_n(pInput, nrVertices, pPolygon);
+		}
+		return nrVertices;
+	}
+}
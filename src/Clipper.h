@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+
+#include "DataTypes.h"
+
+namespace dae
+{
+	//Primitive assembly in homogeneous clip space, before the perspective division
+	//The projection maps the visible depth to 0 <= z <= w, so the near plane is z = 0
+	namespace Clipper
+	{
+		//Planes a clip space position is outside of, one bit each
+		constexpr uint8_t outsideLeft{ 1 << 0 };
+		constexpr uint8_t outsideRight{ 1 << 1 };
+		constexpr uint8_t outsideBottom{ 1 << 2 };
+		constexpr uint8_t outsideTop{ 1 << 3 };
+		constexpr uint8_t outsideNear{ 1 << 4 };
+		constexpr uint8_t outsideFar{ 1 << 5 };
+		constexpr uint8_t outsideGuardBand{ 1 << 6 };
+
+		constexpr uint8_t frustumPlanes{ outsideLeft | outsideRight | outsideBottom | outsideTop | outsideNear | outsideFar };
+		constexpr uint8_t clippingPlanes{ outsideNear | outsideGuardBand };
+
+		//Triangles crossing the screen edges are only clipped once they leave this range (in ndc)
+		//Inside of it the bounding box is clamped to the viewport, which is cheaper and keeps the screen coordinates small
+		constexpr float guardBand{ 4.0f };
+
+		//A triangle clipped by the near plane and the 4 guard band planes
+		constexpr int maxPolygonSize{ 8 };
+
+		uint8_t GetOutsidePlanes(const Vector4& position);
+
+		//Winding of the projected triangle, also correct for vertices behind the camera
+		//Positive for counter clockwise triangles in ndc, 0 for degenerated ones
+		float GetWinding(const Vector4& p0, const Vector4& p1, const Vector4& p2);
+
+		//Clip a triangle against the planes in outsidePlanes, the attributes are interpolated linearly in clip space
+		//Returns the number of vertices of the convex polygon written in pPolygon, less than 3 when nothing is left
+		int ClipTriangle(const Vertex_Out* pTriangle[3], uint8_t outsidePlanes, Vertex_Out* pPolygon);
+	}
+}
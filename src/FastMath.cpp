@@ -0,0 +1,92 @@
+//Project includes
+#include "FastMath.h"
+
+#include <cmath>
+#include <iomanip>
+#include <limits>
+
+using namespace dae;
+
+namespace
+{
+	//Every mantissa of two binades covers the whole table of the estimates, rsqrt also depends on the parity of the exponent
+	//The other normal numbers are sampled with a stride over their bits
+	constexpr uint32_t g_FirstFullBinade{ 0x3F800000u }; //1
+	constexpr uint32_t g_LastFullBinade{ 0x40800000u }; //4
+	constexpr uint32_t g_SampleStride{ 4093 };
+
+	template<typename Function>
+	void ForEachTestedNumber(const Function& function)
+	{
+		for (uint32_t bits{ g_FirstFullBinade }; bits < g_LastFullBinade; ++bits)
+		{
+			function(std::bit_cast<float>(bits));
+		}
+		const uint32_t firstNormal{ std::bit_cast<uint32_t>(std::numeric_limits<float>::min()) };
+		const uint32_t lastNormal{ std::bit_cast<uint32_t>(std::numeric_limits<float>::max()) };
+		for (uint32_t bits{ firstNormal }; bits <= lastNormal - g_SampleStride; bits += g_SampleStride)
+		{
+			function(std::bit_cast<float>(bits));
+		}
+	}
+
+	double GetRelativeError(const float value, const double reference)
+	{
+		return std::abs(value - reference) / std::abs(reference);
+	}
+
+	bool PrintError(std::ostream& stream, const char* name, const double error, const float bound)
+	{
+		const bool isValid{ error <= bound };
+		stream << "  " << name << ": " << error << " (bound " << bound << ")" << (isValid ? "" : " FAILED") << std::endl;
+		return isValid;
+	}
+}
+
+bool FastMath::Validate(std::ostream& stream)
+{
+	double reciprocalError{ 0.0 };
+	double rsqrtError{ 0.0 };
+	double log2Error{ 0.0 };
+	ForEachTestedNumber([&](const float a)
+		{
+			if (1.0 / a >= std::numeric_limits<float>::min()) reciprocalError = std::max(reciprocalError, GetRelativeError(Reciprocal(a), 1.0 / a));
+			rsqrtError = std::max(rsqrtError, GetRelativeError(Rsqrt(a), 1.0 / std::sqrt(static_cast<double>(a))));
+			log2Error = std::max(log2Error, std::abs(Log2(a) - std::log2(static_cast<double>(a))));
+		});
+
+	double exp2Error{ 0.0 };
+	for (float a{ -126.0f }; a <= 127.0f; a += 1.0f / 1024.0f)
+	{
+		exp2Error = std::max(exp2Error, GetRelativeError(Exp2(a), std::exp2(static_cast<double>(a))));
+	}
+
+	//The range of the specular highlights, the cosine and the glossiness
+	constexpr int nrBases{ 4096 };
+	constexpr int nrExponents{ 1024 };
+	double powError{ 0.0 };
+	for (int baseNr{ 1 }; baseNr <= nrBases; ++baseNr)
+	{
+		const float x{ static_cast<float>(baseNr) / nrBases };
+		for (int exponentNr{ 0 }; exponentNr <= nrExponents; ++exponentNr)
+		{
+			const float y{ maxPowExponent * exponentNr / nrExponents };
+			const double reference{ std::pow(static_cast<double>(x), static_cast<double>(y)) };
+			if (reference < std::numeric_limits<float>::min()) continue;
+			powError = std::max(powError, GetRelativeError(Pow(x, y), reference));
+		}
+	}
+
+	stream << "Fast math, largest errors:" << std::endl;
+	stream << std::setprecision(3);
+	bool isValid{ PrintError(stream, "Reciprocal, relative", reciprocalError, maxReciprocalError) };
+	isValid = PrintError(stream, "Rsqrt, relative", rsqrtError, maxRsqrtError) && isValid;
+	isValid = PrintError(stream, "Log2, absolute", log2Error, maxLog2Error) && isValid;
+	isValid = PrintError(stream, "Exp2, relative", exp2Error, maxExp2Error) && isValid;
+	isValid = PrintError(stream, "Pow, relative", powError, maxPowError) && isValid;
+	stream << std::defaultfloat;
+
+	//The edge cases the shading can hit
+	isValid = isValid && Pow(0.0f, 0.0f) == 1.0f && Pow(0.0f, 2.0f) == 0.0f && Pow(1.0f, maxPowExponent) == 1.0f;
+	return isValid;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <ostream>
+#include <xmmintrin.h>
+
+#include "DataTypes.h"
+
+namespace dae
+{
+	//Math of the per pixel shading, precise uses the standard library and the divisions, fast the approximations of FastMath
+	enum struct MathMode
+	{
+		Precise,
+		Fast
+	};
+
+	//Approximations for the shading hot path, without branches so loops over them can be vectorized
+	//The reciprocal and the inverse square root refine the estimate instructions, the block kernels do the same operations
+	//on rcpps and rsqrtps, which give the same estimates as rcpss and rsqrtss, so every kernel gives the same bits
+	namespace FastMath
+	{
+		//Largest errors against the standard library, checked by Validate
+		//The estimates are only specified to 1.5 * 2^-12, the bounds of the refined values hold for every cpu
+		constexpr float maxReciprocalError{ 3.5e-7f }; //Relative, for every normal number with a normal reciprocal
+		constexpr float maxRsqrtError{ 5e-7f }; //Relative, for every normal number
+		constexpr float maxLog2Error{ 2e-5f }; //Absolute, for every normal number
+		constexpr float maxExp2Error{ 2.5e-7f }; //Relative, for x in [-126, 127], outside of it x is clamped
+		constexpr float maxPowError{ 4e-4f }; //Relative, for x in ]0, 1] and y in [0, maxPowExponent]
+		constexpr float maxPowExponent{ 32.0f };
+
+		//The estimate has 12 bits, one Newton-Raphson step about doubles them
+		inline float Reciprocal(const float a)
+		{
+			const float estimate{ _mm_cvtss_f32(_mm_rcp_ss(_mm_set_ss(a))) };
+			return estimate * (2.0f - a * estimate);
+		}
+		inline float Rsqrt(const float a)
+		{
+			const float estimate{ _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(a))) };
+			return estimate * (1.5f - 0.5f * a * estimate * estimate);
+		}
+		inline Vector3 Normalized(const Vector3& vector)
+		{
+			const float inverseMagnitude{ Rsqrt(vector.x * vector.x + vector.y * vector.y + vector.z * vector.z) };
+			return { vector.x * inverseMagnitude, vector.y * inverseMagnitude, vector.z * inverseMagnitude };
+		}
+
+		//Exponent of the float plus a polynomial of the mantissa in [1, 2[, exact for the powers of two
+		//Zero gives -127 instead of minus infinity
+		inline float Log2(const float a)
+		{
+			const uint32_t bits{ std::bit_cast<uint32_t>(a) };
+			const float exponent{ static_cast<float>(static_cast<int32_t>(bits >> 23) - 127) };
+			const float m{ std::bit_cast<float>((bits & 0x007FFFFFu) | 0x3F800000u) - 1.0f };
+
+			float polynomial{ 0.0463841073f };
+			polynomial = polynomial * m - 0.196266919f;
+			polynomial = polynomial * m + 0.417593777f;
+			polynomial = polynomial * m - 0.709662259f;
+			polynomial = polynomial * m + 1.44196558f;
+			return exponent + polynomial * m;
+		}
+
+		//Polynomial of the fraction in [0, 1[ with the integer part added to the exponent
+		inline float Exp2(float a)
+		{
+			a = std::min(std::max(a, -126.0f), 127.0f);
+			const int32_t truncated{ static_cast<int32_t>(a) };
+			const int32_t integer{ truncated - (a < static_cast<float>(truncated) ? 1 : 0) };
+			const float fraction{ a - static_cast<float>(integer) };
+
+			float polynomial{ 0.00188530865f };
+			polynomial = polynomial * fraction + 0.00897335354f;
+			polynomial = polynomial * fraction + 0.0558359437f;
+			polynomial = polynomial * fraction + 0.240152806f;
+			polynomial = polynomial * fraction + 0.693152487f;
+			const float power{ 1.0f + polynomial * fraction };
+			return std::bit_cast<float>(std::bit_cast<int32_t>(power) + integer * (1 << 23));
+		}
+
+		//For x >= 0, pow(0, 0) is 1 like std::pow
+		//The error of Log2 is multiplied by y, so it grows with the exponent
+		inline float Pow(const float x, const float y)
+		{
+			const float power{ Exp2(y * Log2(x)) };
+			return x > 0.0f ? power : (y == 0.0f ? 1.0f : 0.0f);
+		}
+
+		//Measures the largest error of every function against the standard library, in double precision
+		//Prints them with their bounds, returns false when one is over its bound
+		bool Validate(std::ostream& stream);
+	}
+}
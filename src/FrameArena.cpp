@@ -0,0 +1,142 @@
+//Project includes
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <cassert>
+#include <new>
+
+using namespace dae;
+
+namespace
+{
+	//Cache line, also enough for every SIMD type the kernels use
+	constexpr size_t g_BlockAlignment{ 64 };
+}
+
+LinearArena::LinearArena(const size_t blockSize)
+{
+	AddBlock(blockSize);
+	m_Statistics.nrHeapAllocations = 0;
+}
+LinearArena::~LinearArena()
+{
+	for (const Block& block : m_Blocks)
+	{
+		::operator delete(block.pData, std::align_val_t{ g_BlockAlignment });
+	}
+}
+
+void* LinearArena::Allocate(const size_t size, const size_t alignment)
+{
+	assert(alignment <= g_BlockAlignment && (alignment & (alignment - 1)) == 0);
+
+	//The blocks are aligned, aligning the offset aligns the address
+	size_t offset{ (m_Offset + alignment - 1) & ~(alignment - 1) };
+	while (offset + size > m_Blocks[m_CurrentBlock].size)
+	{
+		//What is left of the current block is wasted until the reset
+		if (m_CurrentBlock + 1 == m_Blocks.size()) AddBlock(std::max(2 * m_Blocks.back().size, size));
+		++m_CurrentBlock;
+		offset = 0;
+	}
+
+	m_Statistics.bytesUsed += offset + size - m_Offset;
+	++m_Statistics.nrAllocations;
+	m_Offset = offset + size;
+	return m_Blocks[m_CurrentBlock].pData + offset;
+}
+
+void LinearArena::Reset()
+{
+	m_Statistics.nrAllocations = 0;
+	m_Statistics.bytesUsed = 0;
+	m_Statistics.nrHeapAllocations = 0;
+	m_CurrentBlock = 0;
+	m_Offset = 0;
+	if (m_Blocks.size() == 1) return;
+
+	//Only after a frame bigger than all the frames before
+	size_t totalSize{ 0 };
+	for (const Block& block : m_Blocks)
+	{
+		totalSize += block.size;
+		::operator delete(block.pData, std::align_val_t{ g_BlockAlignment });
+	}
+	m_Blocks.clear();
+	m_Statistics.bytesReserved = 0;
+	AddBlock(totalSize);
+}
+
+const LinearArena::Statistics& LinearArena::GetStatistics() const
+{
+	return m_Statistics;
+}
+
+void LinearArena::AddBlock(const size_t minSize)
+{
+	const size_t size{ (minSize + g_BlockAlignment - 1) / g_BlockAlignment * g_BlockAlignment };
+	m_Blocks.push_back({ static_cast<uint8_t*>(::operator new(size, std::align_val_t{ g_BlockAlignment })), size });
+	m_Statistics.bytesReserved += size;
+	++m_Statistics.nrHeapAllocations;
+}
+
+LinearArena& FrameArena::GetMainArena()
+{
+	return m_MainArena;
+}
+
+LinearArena& FrameArena::GetThreadArena()
+{
+	const std::thread::id threadId{ std::this_thread::get_id() };
+
+	std::lock_guard lock{ m_Mutex };
+	for (ThreadArena& threadArena : m_ThreadArenas)
+	{
+		if (threadArena.threadId != threadId) continue;
+
+		threadArena.isUsed = true;
+		return *threadArena.pArena;
+	}
+
+	//A thread the pool retired, or one that didn't allocate this frame, keeps its blocks for the new one
+	for (ThreadArena& threadArena : m_ThreadArenas)
+	{
+		if (threadArena.isUsed) continue;
+
+		threadArena.threadId = threadId;
+		threadArena.isUsed = true;
+		return *threadArena.pArena;
+	}
+
+	//The block of a worker only holds what it binned, smaller than the main one
+	m_ThreadArenas.push_back({ threadId, std::make_unique<LinearArena>(1 << 16), true });
+	return *m_ThreadArenas.back().pArena;
+}
+
+void FrameArena::Reset()
+{
+	m_MainArena.Reset();
+
+	std::lock_guard lock{ m_Mutex };
+	for (ThreadArena& threadArena : m_ThreadArenas)
+	{
+		threadArena.pArena->Reset();
+		threadArena.isUsed = false;
+	}
+}
+
+LinearArena::Statistics FrameArena::GetStatistics() const
+{
+	LinearArena::Statistics statistics{ m_MainArena.GetStatistics() };
+
+	std::lock_guard lock{ m_Mutex };
+	for (const ThreadArena& threadArena : m_ThreadArenas)
+	{
+		const LinearArena::Statistics& threadStatistics{ threadArena.pArena->GetStatistics() };
+		statistics.nrAllocations += threadStatistics.nrAllocations;
+		statistics.bytesUsed += threadStatistics.bytesUsed;
+		statistics.bytesReserved += threadStatistics.bytesReserved;
+		statistics.nrHeapAllocations += threadStatistics.nrHeapAllocations;
+	}
+	return statistics;
+}
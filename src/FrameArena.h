@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace dae
+{
+	//Bump allocator for the data that only lives during one frame
+	//Reset makes all the memory free again at once, the blocks are kept so the next frames don't allocate
+	class LinearArena final
+	{
+	public:
+		struct Statistics
+		{
+			uint64_t nrAllocations{}; //Since the last reset
+			uint64_t bytesUsed{}; //Since the last reset, with the alignment padding
+			uint64_t bytesReserved{}; //Size of all the blocks
+			uint64_t nrHeapAllocations{}; //Blocks allocated since the last reset, 0 once the frames fit
+		};
+
+		explicit LinearArena(size_t blockSize = m_DefaultBlockSize);
+		~LinearArena();
+
+		LinearArena(const LinearArena&) = delete;
+		LinearArena(LinearArena&&) noexcept = delete;
+		LinearArena& operator=(const LinearArena&) = delete;
+		LinearArena& operator=(LinearArena&&) noexcept = delete;
+
+		void* Allocate(size_t size, size_t alignment);
+
+		//The elements are not initialized, every one of them has to be written before it is read
+		//Nothing is destroyed by the reset, so only trivial types can be stored
+		template<typename T>
+		std::span<T> Allocate(const size_t count)
+		{
+			static_assert(std::is_trivially_destructible_v<T> && std::is_trivially_copyable_v<T>, "The arena never runs destructors");
+			if (count == 0) return {};
+			return { static_cast<T*>(Allocate(count * sizeof(T), alignof(T))), count };
+		}
+
+		//Everything allocated before is invalid
+		//When the last frame needed more than one block they are merged, so the next one fits in a single block
+		void Reset();
+
+		const Statistics& GetStatistics() const;
+
+	private:
+		static constexpr size_t m_DefaultBlockSize{ 1 << 20 };
+
+		struct Block
+		{
+			uint8_t* pData{};
+			size_t size{};
+		};
+
+		void AddBlock(size_t minSize);
+
+		std::vector<Block> m_Blocks{};
+		size_t m_CurrentBlock{};
+		size_t m_Offset{}; //In the current block
+		Statistics m_Statistics{};
+	};
+
+	//Arena of one frame data, with a sub-arena for every thread that allocates from it
+	//The workers of a parallel loop never share a block, so they don't have to lock to allocate
+	//A sub-arena not used since the last reset is given to the next new thread, so thread pools that replace
+	//their idle workers don't add arenas, there are never more than the threads allocating during one frame
+	class FrameArena final
+	{
+	public:
+		FrameArena() = default;
+		~FrameArena() = default;
+
+		FrameArena(const FrameArena&) = delete;
+		FrameArena(FrameArena&&) noexcept = delete;
+		FrameArena& operator=(const FrameArena&) = delete;
+		FrameArena& operator=(FrameArena&&) noexcept = delete;
+
+		//Of the thread that prepares the frame, for the data that outlives the parallel loops
+		LinearArena& GetMainArena();
+		//Of the calling thread, only locks to find it
+		//Only allocates when more threads than ever before allocate during the same frame
+		LinearArena& GetThreadArena();
+
+		//Every allocation of every thread is invalid, no worker can use the arena anymore
+		void Reset();
+
+		//Summed over the main and the thread arenas
+		LinearArena::Statistics GetStatistics() const;
+
+	private:
+		struct ThreadArena
+		{
+			std::thread::id threadId{};
+			std::unique_ptr<LinearArena> pArena{};
+			bool isUsed{}; //Since the last reset, only the unused ones can change thread
+		};
+
+		LinearArena m_MainArena{};
+
+		mutable std::mutex m_Mutex{};
+		std::vector<ThreadArena> m_ThreadArenas{};
+	};
+}
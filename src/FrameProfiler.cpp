@@ -0,0 +1,272 @@
+//Project includes
+#include "FrameProfiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+using namespace dae;
+
+FrameCounters& FrameCounters::operator+=(const FrameCounters& other)
+{
+	instancesCulled += other.instancesCulled;
+	trianglesCulled += other.trianglesCulled;
+	trianglesBackFacing += other.trianglesBackFacing;
+	trianglesClipped += other.trianglesClipped;
+	trianglesOccluded += other.trianglesOccluded;
+	trianglesRasterized += other.trianglesRasterized;
+	pixelsTested += other.pixelsTested;
+	pixelsDepthPassed += other.pixelsDepthPassed;
+	pixelsShaded += other.pixelsShaded;
+	tilesRendered += other.tilesRendered;
+	for (size_t lod{ 0 }; lod < maxNrLods; ++lod)
+	{
+		instancesPerLod[lod] += other.instancesPerLod[lod];
+		trianglesPerLod[lod] += other.trianglesPerLod[lod];
+	}
+	arenaAllocations += other.arenaAllocations;
+	arenaBytesUsed += other.arenaBytesUsed;
+	arenaBytesReserved += other.arenaBytesReserved;
+	arenaHeapAllocations += other.arenaHeapAllocations;
+	return *this;
+}
+
+FrameProfiler::FrameProfiler(const size_t maxFrames)
+{
+	SetMaxFrames(maxFrames);
+}
+
+void FrameProfiler::SetEnabled(const bool isEnabled)
+{
+	m_IsEnabled = isEnabled;
+}
+bool FrameProfiler::IsEnabled() const
+{
+	return m_IsEnabled;
+}
+
+void FrameProfiler::SetMaxFrames(const size_t maxFrames)
+{
+	m_MaxFrames = std::max<size_t>(maxFrames, 1);
+	m_Frames.reserve(m_MaxFrames);
+	m_SortedTimes.reserve(m_MaxFrames);
+	Reset();
+}
+void FrameProfiler::Reset()
+{
+	m_Frames.clear();
+	m_NextFrame = 0;
+	m_CurrentFrame = FrameRecord{};
+}
+
+void FrameProfiler::BeginFrame()
+{
+	m_CurrentFrame = FrameRecord{};
+}
+void FrameProfiler::AddStageTime(const ProfileStage stage, const double milliseconds)
+{
+	m_CurrentFrame.stageMs[static_cast<int>(stage)] += milliseconds;
+}
+void FrameProfiler::AddCounters(const FrameCounters& counters)
+{
+	m_CurrentFrame.counters += counters;
+}
+void FrameProfiler::EndFrame()
+{
+	if (!m_IsEnabled) return;
+
+	//Overwrite the oldest frame once the history is full
+	if (m_Frames.size() < m_MaxFrames)
+	{
+		m_Frames.push_back(m_CurrentFrame);
+	}
+	else
+	{
+		m_Frames[m_NextFrame] = m_CurrentFrame;
+	}
+	m_NextFrame = (m_NextFrame + 1) % m_MaxFrames;
+}
+
+size_t FrameProfiler::GetNrFrames() const
+{
+	return m_Frames.size();
+}
+
+FrameProfiler::StageSummary FrameProfiler::GetStageSummary(const ProfileStage stage) const
+{
+	if (m_Frames.empty()) return StageSummary{};
+
+	m_SortedTimes.clear();
+	double totalMs{};
+	for (const FrameRecord& frame : m_Frames)
+	{
+		const double stageMs{ frame.stageMs[static_cast<int>(stage)] };
+		m_SortedTimes.push_back(stageMs);
+		totalMs += stageMs;
+	}
+	std::sort(m_SortedTimes.begin(), m_SortedTimes.end());
+
+	//Nearest rank percentile
+	const size_t p99Rank{ static_cast<size_t>(std::ceil(0.99 * m_SortedTimes.size())) };
+
+	StageSummary summary{};
+	summary.minMs = m_SortedTimes.front();
+	summary.averageMs = totalMs / m_SortedTimes.size();
+	summary.p99Ms = m_SortedTimes[std::max<size_t>(p99Rank, 1) - 1];
+	return summary;
+}
+
+FrameCounters FrameProfiler::GetAverageCounters() const
+{
+	if (m_Frames.empty()) return FrameCounters{};
+
+	FrameCounters total{};
+	for (const FrameRecord& frame : m_Frames)
+	{
+		total += frame.counters;
+	}
+
+	const uint64_t nrFrames{ m_Frames.size() };
+	total.instancesCulled /= nrFrames;
+	total.trianglesCulled /= nrFrames;
+	total.trianglesBackFacing /= nrFrames;
+	total.trianglesClipped /= nrFrames;
+	total.trianglesOccluded /= nrFrames;
+	total.trianglesRasterized /= nrFrames;
+	total.pixelsTested /= nrFrames;
+	total.pixelsDepthPassed /= nrFrames;
+	total.pixelsShaded /= nrFrames;
+	total.tilesRendered /= nrFrames;
+	for (size_t lod{ 0 }; lod < FrameCounters::maxNrLods; ++lod)
+	{
+		total.instancesPerLod[lod] /= nrFrames;
+		total.trianglesPerLod[lod] /= nrFrames;
+	}
+	total.arenaAllocations /= nrFrames;
+	total.arenaBytesUsed /= nrFrames;
+	total.arenaBytesReserved /= nrFrames;
+	total.arenaHeapAllocations /= nrFrames;
+	return total;
+}
+
+void FrameProfiler::PrintReport(std::ostream& stream) const
+{
+	stream << "Profile of the last " << m_Frames.size() << " frames (ms, min / avg / p99)" << std::endl;
+	stream << std::fixed << std::setprecision(3);
+	for (int stage{ 0 }; stage < static_cast<int>(ProfileStage::Count); ++stage)
+	{
+		const StageSummary summary{ GetStageSummary(static_cast<ProfileStage>(stage)) };
+		stream << "  " << std::left << std::setw(22) << GetStageName(static_cast<ProfileStage>(stage)) << std::right
+			<< summary.minMs << " / " << summary.averageMs << " / " << summary.p99Ms << std::endl;
+	}
+	stream << std::defaultfloat;
+
+	const FrameCounters counters{ GetAverageCounters() };
+	stream << "  Instances culled: " << counters.instancesCulled << std::endl;
+	stream << "  Triangles culled / back facing / clipped / rasterized: " << counters.trianglesCulled << " / " << counters.trianglesBackFacing
+		<< " / " << counters.trianglesClipped << " / " << counters.trianglesRasterized << std::endl;
+	stream << "  Triangle tiles occluded: " << counters.trianglesOccluded << std::endl;
+	stream << "  Pixels tested / depth passed / shaded: " << counters.pixelsTested << " / " << counters.pixelsDepthPassed << " / " << counters.pixelsShaded << std::endl;
+	stream << "  Tiles rendered: " << counters.tilesRendered << std::endl;
+	stream << "  Instances / triangles per LOD:";
+	for (size_t lod{ 0 }; lod < FrameCounters::maxNrLods; ++lod)
+	{
+		stream << (lod ? ", " : " ") << counters.instancesPerLod[lod] << " / " << counters.trianglesPerLod[lod];
+	}
+	stream << std::endl;
+	stream << "  Frame arena allocations / bytes used / bytes reserved / heap allocations: " << counters.arenaAllocations << " / " << counters.arenaBytesUsed
+		<< " / " << counters.arenaBytesReserved << " / " << counters.arenaHeapAllocations << std::endl;
+}
+
+void FrameProfiler::WriteJson(std::ostream& stream, const char* indent) const
+{
+	stream << "{\n";
+	stream << indent << "\t\"frames\": " << m_Frames.size() << ",\n";
+	stream << indent << "\t\"stages\": {\n";
+	for (int stage{ 0 }; stage < static_cast<int>(ProfileStage::Count); ++stage)
+	{
+		const StageSummary summary{ GetStageSummary(static_cast<ProfileStage>(stage)) };
+		stream << indent << "\t\t\"" << GetStageName(static_cast<ProfileStage>(stage)) << "\": { "
+			<< "\"minMs\": " << summary.minMs << ", "
+			<< "\"avgMs\": " << summary.averageMs << ", "
+			<< "\"p99Ms\": " << summary.p99Ms << " }"
+			<< (stage + 1 < static_cast<int>(ProfileStage::Count) ? ",\n" : "\n");
+	}
+	stream << indent << "\t},\n";
+
+	const FrameCounters counters{ GetAverageCounters() };
+	stream << indent << "\t\"countersPerFrame\": { "
+		<< "\"instancesCulled\": " << counters.instancesCulled << ", "
+		<< "\"trianglesCulled\": " << counters.trianglesCulled << ", "
+		<< "\"trianglesBackFacing\": " << counters.trianglesBackFacing << ", "
+		<< "\"trianglesClipped\": " << counters.trianglesClipped << ", "
+		<< "\"trianglesOccluded\": " << counters.trianglesOccluded << ", "
+		<< "\"trianglesRasterized\": " << counters.trianglesRasterized << ", "
+		<< "\"pixelsTested\": " << counters.pixelsTested << ", "
+		<< "\"pixelsDepthPassed\": " << counters.pixelsDepthPassed << ", "
+		<< "\"pixelsShaded\": " << counters.pixelsShaded << ", "
+		<< "\"tilesRendered\": " << counters.tilesRendered << ", ";
+	const auto writeLods = [&stream](const char* name, const uint64_t(&values)[FrameCounters::maxNrLods])
+		{
+			stream << "\"" << name << "\": [";
+			for (size_t lod{ 0 }; lod < FrameCounters::maxNrLods; ++lod)
+			{
+				stream << (lod ? ", " : "") << values[lod];
+			}
+			stream << "], ";
+		};
+	writeLods("instancesPerLod", counters.instancesPerLod);
+	writeLods("trianglesPerLod", counters.trianglesPerLod);
+	stream
+		<< "\"arenaAllocations\": " << counters.arenaAllocations << ", "
+		<< "\"arenaBytesUsed\": " << counters.arenaBytesUsed << ", "
+		<< "\"arenaBytesReserved\": " << counters.arenaBytesReserved << ", "
+		<< "\"arenaHeapAllocations\": " << counters.arenaHeapAllocations << " }\n";
+	stream << indent << "}";
+}
+
+const char* FrameProfiler::GetStageName(const ProfileStage stage)
+{
+	switch (stage)
+	{
+	case ProfileStage::Frame:
+		return "Frame";
+	case ProfileStage::Clear:
+		return "Clear";
+	case ProfileStage::VertexTransformation:
+		return "VertexTransformation";
+	case ProfileStage::ScreenSpace:
+		return "ScreenSpace";
+	case ProfileStage::Rasterization:
+		return "Rasterization";
+	case ProfileStage::PixelShading:
+		return "PixelShading";
+	case ProfileStage::Present:
+		return "Present";
+	default:
+		return "Unknown";
+	}
+}
+
+double FrameProfiler::ToMilliseconds(const Clock::duration duration)
+{
+	return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+ScopedStageTimer::ScopedStageTimer(FrameProfiler& profiler, const ProfileStage stage) :
+	m_Profiler(profiler),
+	m_Stage(stage),
+	m_IsEnabled(profiler.IsEnabled())
+{
+	if (m_IsEnabled)
+	{
+		m_Start = FrameProfiler::Clock::now();
+	}
+}
+ScopedStageTimer::~ScopedStageTimer()
+{
+	if (m_IsEnabled)
+	{
+		m_Profiler.AddStageTime(m_Stage, FrameProfiler::ToMilliseconds(FrameProfiler::Clock::now() - m_Start));
+	}
+}
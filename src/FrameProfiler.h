@@ -0,0 +1,121 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace dae
+{
+	enum struct ProfileStage
+	{
+		Frame, //Whole Render call
+		Clear,
+		VertexTransformation,
+		ScreenSpace, //Screen space conversion, triangle setup and binning
+		Rasterization,
+		PixelShading,
+		Present,
+		Count
+	};
+
+	//Work done during a frame
+	struct FrameCounters
+	{
+		uint64_t instancesCulled{}; //Outside of the view frustum, none of their vertices were transformed
+		uint64_t trianglesCulled{}; //Outside of the screen, fully clipped or degenerated
+		uint64_t trianglesBackFacing{};
+		uint64_t trianglesClipped{}; //Crossing the near plane or the guard band, split before being rasterized
+		uint64_t trianglesOccluded{}; //Skipped by a tile because of the hierarchical depth, counted once per tile
+		uint64_t trianglesRasterized{};
+		uint64_t pixelsTested{};
+		uint64_t pixelsDepthPassed{};
+		uint64_t pixelsShaded{};
+		uint64_t tilesRendered{}; //0 when the last frame was reused, less than all tiles when only some instances moved
+
+		//Levels of detail of the visible instances, see Renderer::SelectLods
+		static constexpr size_t maxNrLods{ 4 };
+		uint64_t instancesPerLod[maxNrLods]{};
+		uint64_t trianglesPerLod[maxNrLods]{}; //Triangles of the level, before any of them is culled
+
+		//Frame arena, see FrameArena
+		uint64_t arenaAllocations{};
+		uint64_t arenaBytesUsed{};
+		uint64_t arenaBytesReserved{};
+		uint64_t arenaHeapAllocations{}; //New blocks, 0 in the steady state
+
+		FrameCounters& operator+=(const FrameCounters& other);
+	};
+
+	//Keeps the stage times and counters of the last frames and reports min/avg/p99 per stage
+	//Clear, Rasterization and PixelShading run on the tile workers, their time is summed over the workers
+	class FrameProfiler final
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		struct StageSummary
+		{
+			double minMs{};
+			double averageMs{};
+			double p99Ms{};
+		};
+
+		explicit FrameProfiler(size_t maxFrames = 240);
+
+		void SetEnabled(bool isEnabled);
+		bool IsEnabled() const;
+
+		//Only the last maxFrames frames are kept, the memory is allocated once
+		void SetMaxFrames(size_t maxFrames);
+		void Reset();
+
+		void BeginFrame();
+		void AddStageTime(ProfileStage stage, double milliseconds);
+		void AddCounters(const FrameCounters& counters);
+		void EndFrame();
+
+		size_t GetNrFrames() const;
+		StageSummary GetStageSummary(ProfileStage stage) const;
+		FrameCounters GetAverageCounters() const;
+
+		void PrintReport(std::ostream& stream) const;
+		void WriteJson(std::ostream& stream, const char* indent) const; //Writes one json object
+
+		static const char* GetStageName(ProfileStage stage);
+		static double ToMilliseconds(Clock::duration duration);
+
+	private:
+		struct FrameRecord
+		{
+			double stageMs[static_cast<int>(ProfileStage::Count)]{};
+			FrameCounters counters{};
+		};
+
+		bool m_IsEnabled{ false };
+		size_t m_MaxFrames{};
+		size_t m_NextFrame{}; //Ring buffer position
+		std::vector<FrameRecord> m_Frames{};
+		FrameRecord m_CurrentFrame{};
+		mutable std::vector<double> m_SortedTimes{}; //Scratch buffer for the percentiles
+	};
+
+	//Adds the time between its construction and destruction to a stage, does nothing when the profiler is disabled
+	class ScopedStageTimer final
+	{
+	public:
+		ScopedStageTimer(FrameProfiler& profiler, ProfileStage stage);
+		~ScopedStageTimer();
+
+		ScopedStageTimer(const ScopedStageTimer&) = delete;
+		ScopedStageTimer(ScopedStageTimer&&) noexcept = delete;
+		ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+		ScopedStageTimer& operator=(ScopedStageTimer&&) noexcept = delete;
+
+	private:
+		FrameProfiler& m_Profiler;
+		const ProfileStage m_Stage;
+		const bool m_IsEnabled;
+		FrameProfiler::Clock::time_point m_Start{};
+	};
+}
@@ -0,0 +1,146 @@
+//External includes
+#include "SDL.h"
+
+//Project includes
+#include "FrameWriter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+using namespace dae;
+
+FrameWriter::FrameWriter(const std::string& directory, const FrameFileFormat format, const int width, const int height, const SDL_PixelFormat* pPixelFormat, const size_t maxQueuedFrames) :
+	m_Directory(directory),
+	m_Format(format),
+	m_Width(width),
+	m_Height(height),
+	m_MaxQueuedFrames(std::max<size_t>(maxQueuedFrames, 1)),
+	m_RedShift(pPixelFormat->Rshift),
+	m_GreenShift(pPixelFormat->Gshift),
+	m_BlueShift(pPixelFormat->Bshift)
+{
+	std::error_code error{};
+	std::filesystem::create_directories(m_Directory, error);
+
+	//Started last, everything it uses is initialized
+	m_Thread = std::thread{ &FrameWriter::WriteLoop, this };
+}
+FrameWriter::~FrameWriter()
+{
+	{
+		std::lock_guard lock{ m_Mutex };
+		m_IsStopping = true;
+	}
+	m_FrameQueued.notify_one();
+	m_Thread.join();
+}
+
+void FrameWriter::Submit(const uint32_t* pPixels)
+{
+	const size_t nrPixels{ static_cast<size_t>(m_Width) * m_Height };
+
+	Frame frame{};
+	{
+		//Back pressure, wait for the disk instead of queuing frames forever
+		std::unique_lock lock{ m_Mutex };
+		m_FrameWritten.wait(lock, [this]() { return m_QueuedFrames.size() < m_MaxQueuedFrames; });
+
+		frame.number = m_NrSubmittedFrames++;
+		if (!m_FreeBuffers.empty())
+		{
+			frame.pixels = std::move(m_FreeBuffers.back());
+			m_FreeBuffers.pop_back();
+		}
+	}
+
+	//Copy outside of the lock, the writer thread can keep going meanwhile
+	frame.pixels.assign(pPixels, pPixels + nrPixels);
+
+	{
+		std::lock_guard lock{ m_Mutex };
+		m_QueuedFrames.push_back(std::move(frame));
+	}
+	m_FrameQueued.notify_one();
+}
+
+int FrameWriter::GetNrWrittenFrames() const
+{
+	std::lock_guard lock{ m_Mutex };
+	return m_NrWrittenFrames;
+}
+bool FrameWriter::HasFailed() const
+{
+	std::lock_guard lock{ m_Mutex };
+	return m_HasFailed;
+}
+
+void FrameWriter::WriteLoop()
+{
+	std::vector<uint8_t> bytes{};
+
+	while (true)
+	{
+		Frame frame{};
+		{
+			std::unique_lock lock{ m_Mutex };
+			m_FrameQueued.wait(lock, [this]() { return m_IsStopping || !m_QueuedFrames.empty(); });
+
+			//Only stop once everything that was submitted is written
+			if (m_QueuedFrames.empty()) return;
+
+			frame = std::move(m_QueuedFrames.front());
+			m_QueuedFrames.pop_front();
+		}
+
+		const bool isWritten{ WriteFrame(frame, bytes) };
+
+		{
+			std::lock_guard lock{ m_Mutex };
+			++m_NrWrittenFrames;
+			m_HasFailed = m_HasFailed || !isWritten;
+			m_FreeBuffers.push_back(std::move(frame.pixels));
+		}
+		m_FrameWritten.notify_one();
+	}
+}
+
+bool FrameWriter::WriteFrame(const Frame& frame, std::vector<uint8_t>& bytes) const
+{
+	const bool isPPM{ m_Format == FrameFileFormat::PPM };
+	const size_t nrChannels{ isPPM ? 3u : 4u };
+
+	//Convert the back buffer pixels to bytes in rgb(a) order
+	bytes.resize(frame.pixels.size() * nrChannels);
+	uint8_t* pByte{ bytes.data() };
+	for (const uint32_t pixel : frame.pixels)
+	{
+		*pByte++ = static_cast<uint8_t>(pixel >> m_RedShift);
+		*pByte++ = static_cast<uint8_t>(pixel >> m_GreenShift);
+		*pByte++ = static_cast<uint8_t>(pixel >> m_BlueShift);
+		if (!isPPM)
+		{
+			*pByte++ = 255;
+		}
+	}
+
+	char fileName[32]{};
+	std::snprintf(fileName, sizeof(fileName), "frame_%05d.%s", frame.number, isPPM ? "ppm" : "rgba");
+
+	std::ofstream file{ std::filesystem::path{ m_Directory } / fileName, std::ios::binary };
+	if (!file)
+	{
+		std::cout << "Could not open " << fileName << " for writing" << std::endl;
+		return false;
+	}
+
+	if (isPPM)
+	{
+		file << "P6\n" << m_Width << ' ' << m_Height << "\n255\n";
+	}
+	file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+
+	return static_cast<bool>(file);
+}
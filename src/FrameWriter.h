@@ -0,0 +1,74 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct SDL_PixelFormat;
+
+namespace dae
+{
+	enum struct FrameFileFormat
+	{
+		PPM, //Binary P6, rgb
+		RGBA //Raw 8 bit per channel, no header
+	};
+
+	//Streams rendered frames to disk on a background thread, so the render loop only pays for a copy
+	class FrameWriter final
+	{
+	public:
+		//Frames are written as directory/frame_00000.ppm (or .rgba)
+		//maxQueuedFrames bounds the memory used when the disk is slower than the renderer
+		FrameWriter(const std::string& directory, FrameFileFormat format, int width, int height, const SDL_PixelFormat* pPixelFormat, size_t maxQueuedFrames = 8);
+		~FrameWriter(); //Waits until every submitted frame is on disk
+
+		FrameWriter(const FrameWriter&) = delete;
+		FrameWriter(FrameWriter&&) noexcept = delete;
+		FrameWriter& operator=(const FrameWriter&) = delete;
+		FrameWriter& operator=(FrameWriter&&) noexcept = delete;
+
+		//Copies the pixels of the frame, only blocks when maxQueuedFrames frames are still waiting
+		void Submit(const uint32_t* pPixels);
+
+		int GetNrWrittenFrames() const;
+		bool HasFailed() const;
+
+	private:
+		struct Frame
+		{
+			int number{};
+			std::vector<uint32_t> pixels{};
+		};
+
+		void WriteLoop();
+		bool WriteFrame(const Frame& frame, std::vector<uint8_t>& bytes) const;
+
+		const std::string m_Directory;
+		const FrameFileFormat m_Format;
+		const int m_Width;
+		const int m_Height;
+		const size_t m_MaxQueuedFrames;
+
+		//Position of the channels in a pixel of the back buffer
+		uint8_t m_RedShift{};
+		uint8_t m_GreenShift{};
+		uint8_t m_BlueShift{};
+
+		mutable std::mutex m_Mutex{};
+		std::condition_variable m_FrameQueued{};
+		std::condition_variable m_FrameWritten{};
+		std::deque<Frame> m_QueuedFrames{};
+		std::vector<std::vector<uint32_t>> m_FreeBuffers{}; //Recycled pixel copies
+		int m_NrSubmittedFrames{};
+		int m_NrWrittenFrames{};
+		bool m_HasFailed{ false };
+		bool m_IsStopping{ false };
+
+		std::thread m_Thread;
+	};
+}
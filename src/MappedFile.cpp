@@ -0,0 +1,72 @@
+//Project includes
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace dae;
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::string& path)
+{
+	const HANDLE fileHandle{ CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr) };
+	if (fileHandle == INVALID_HANDLE_VALUE) return;
+	m_pFileHandle = fileHandle;
+
+	LARGE_INTEGER size{};
+	if (!GetFileSizeEx(fileHandle, &size) || size.QuadPart == 0) return;
+
+	m_pMappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!m_pMappingHandle) return;
+
+	m_pData = static_cast<const uint8_t*>(MapViewOfFile(m_pMappingHandle, FILE_MAP_READ, 0, 0, 0));
+	if (m_pData) m_Size = static_cast<size_t>(size.QuadPart);
+}
+MappedFile::~MappedFile()
+{
+	if (m_pData) UnmapViewOfFile(m_pData);
+	if (m_pMappingHandle) CloseHandle(m_pMappingHandle);
+	if (m_pFileHandle) CloseHandle(m_pFileHandle);
+}
+#else
+MappedFile::MappedFile(const std::string& path)
+{
+	m_FileDescriptor = open(path.c_str(), O_RDONLY);
+	if (m_FileDescriptor < 0) return;
+
+	struct stat status{};
+	if (fstat(m_FileDescriptor, &status) != 0 || status.st_size == 0) return;
+
+	void* pData{ mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, m_FileDescriptor, 0) };
+	if (pData == MAP_FAILED) return;
+
+	m_pData = static_cast<const uint8_t*>(pData);
+	m_Size = static_cast<size_t>(status.st_size);
+}
+MappedFile::~MappedFile()
+{
+	if (m_pData) munmap(const_cast<uint8_t*>(m_pData), m_Size);
+	if (m_FileDescriptor >= 0) close(m_FileDescriptor);
+}
+#endif
+
+bool MappedFile::IsOpen() const
+{
+	return m_pData != nullptr;
+}
+const uint8_t* MappedFile::GetData() const
+{
+	return m_pData;
+}
+size_t MappedFile::GetSize() const
+{
+	return m_Size;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace dae
+{
+	//Read only view of a whole file mapped in memory, the pages are only read from disk when they are touched
+	class MappedFile final
+	{
+	public:
+		explicit MappedFile(const std::string& path); //Check IsOpen, the file may not exist
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile(MappedFile&&) noexcept = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile& operator=(MappedFile&&) noexcept = delete;
+
+		bool IsOpen() const;
+		const uint8_t* GetData() const;
+		size_t GetSize() const;
+
+	private:
+		const uint8_t* m_pData{ nullptr };
+		size_t m_Size{};
+
+#ifdef _WIN32
+		void* m_pFileHandle{ nullptr };
+		void* m_pMappingHandle{ nullptr };
+#else
+		int m_FileDescriptor{ -1 };
+#endif
+	};
+}
@@ -0,0 +1,109 @@
+//Project includes
+#include "Material.h"
+
+#include <iostream>
+#include <memory>
+
+using namespace dae;
+
+namespace
+{
+	//Loads an optional map, only kept when it has the size of the diffuse map so both share the same layout
+	std::unique_ptr<MipTexture> LoadMap(const std::string& path, const MipTexture& diffuse, const bool isNormalMap)
+	{
+		if (path.empty()) return nullptr;
+
+		std::unique_ptr<MipTexture> pMap{ MipTexture::LoadFromFile(path, isNormalMap) };
+		if (!pMap) return nullptr;
+
+		if (pMap->GetLayout().GetWidth(0) != diffuse.GetLayout().GetWidth(0) || pMap->GetLayout().GetHeight(0) != diffuse.GetLayout().GetHeight(0))
+		{
+			std::cout << path << " doesn't have the size of the diffuse map, it is left out of the material" << std::endl;
+			return nullptr;
+		}
+		return pMap;
+	}
+
+	void AddChannels(const uint32_t word, const int nrChannels, const float weight, float* pChannels)
+	{
+		for (int channel{ 0 }; channel < nrChannels; ++channel)
+		{
+			pChannels[channel] += ((word >> (channel * 8)) & 0xFF) * weight;
+		}
+	}
+}
+
+Material* Material::LoadFromFiles(const std::string& diffusePath, const std::string& normalPath,
+	const std::string& glossPath, const std::string& specularPath)
+{
+	const std::unique_ptr<MipTexture> pDiffuse{ MipTexture::LoadFromFile(diffusePath) };
+	if (!pDiffuse) return nullptr;
+
+	//The separate maps are only needed while packing
+	const std::unique_ptr<MipTexture> pNormal{ LoadMap(normalPath, *pDiffuse, true) };
+	const std::unique_ptr<MipTexture> pGloss{ LoadMap(glossPath, *pDiffuse, false) };
+	const std::unique_ptr<MipTexture> pSpecular{ LoadMap(specularPath, *pDiffuse, false) };
+
+	return new Material(*pDiffuse, pNormal.get(), pGloss.get(), pSpecular.get());
+}
+
+Material::Material(const MipTexture& diffuse, const MipTexture* pNormal, const MipTexture* pGloss, const MipTexture* pSpecular) :
+	m_Layout(diffuse.GetLayout()),
+	m_HasNormalMap(pNormal != nullptr)
+{
+	//All the maps have the same size, so the same texel index in every map is the same uv
+	const std::vector<uint32_t>& diffuseTexels{ diffuse.GetTexels() };
+	m_Texels.resize(diffuseTexels.size());
+
+	for (size_t index{ 0 }; index < m_Texels.size(); ++index)
+	{
+		Texel& texel{ m_Texels[index] };
+		texel.diffuseGloss = diffuseTexels[index];
+		if (pGloss) texel.diffuseGloss |= (pGloss->GetTexels()[index] & 0xFF) << 24;
+		if (pNormal) texel.normal = pNormal->GetTexels()[index];
+		if (pSpecular) texel.specular = pSpecular->GetTexels()[index];
+	}
+}
+
+MaterialSample Material::Sample(const Vector2& uv) const
+{
+	const Texel& texel{ m_Texels[m_Layout.GetNearestTexel(uv)] };
+
+	float channels[10]{};
+	AddChannels(texel.diffuseGloss, 4, 1.0f, channels);
+	AddChannels(texel.normal, 3, 1.0f, channels + 4);
+	AddChannels(texel.specular, 3, 1.0f, channels + 7);
+	return ToSample(channels);
+}
+
+MaterialSample Material::Sample(const Vector2& uv, const TextureGradient& gradient) const
+{
+	float channels[10]{};
+	m_Layout.ForEachTrilinearTexel(uv, gradient, [this, &channels](const size_t index, const float weight)
+		{
+			const Texel& texel{ m_Texels[index] };
+			AddChannels(texel.diffuseGloss, 4, weight, channels);
+			AddChannels(texel.normal, 3, weight, channels + 4);
+			AddChannels(texel.specular, 3, weight, channels + 7);
+		});
+
+	return ToSample(channels);
+}
+
+bool Material::HasNormalMap() const
+{
+	return m_HasNormalMap;
+}
+
+MaterialSample Material::ToSample(const float channels[10])
+{
+	MaterialSample sample{};
+	sample.diffuse = { channels[0] / 255.f, channels[1] / 255.f, channels[2] / 255.f };
+	sample.gloss = channels[3] / 255.f;
+
+	//Same operations as the separate normal map, [0, 1] to [-1, 1]
+	sample.normal = { channels[4] / 255.f * 2.0f - 1.0f, channels[5] / 255.f * 2.0f - 1.0f, channels[6] / 255.f * 2.0f - 1.0f };
+
+	sample.specular = { channels[7] / 255.f, channels[8] / 255.f, channels[9] / 255.f };
+	return sample;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MipTexture.h"
+
+namespace dae
+{
+	//Everything the pixel shading reads from the maps at one uv
+	struct MaterialSample
+	{
+		ColorRGB diffuse{};
+		Vector3 normal{}; //Tangent space, in [-1, 1] and not normalized
+		float gloss{}; //Red channel of the gloss map
+		ColorRGB specular{};
+	};
+
+	//Diffuse, normal, gloss and specular maps sharing the uv set of a mesh, packed in one texture at load time
+	//A texel is a 16 byte record, so a pixel reads one cache line instead of four separate images
+	class Material final
+	{
+	public:
+		~Material() = default;
+
+		Material(const Material&) = delete;
+		Material(Material&&) noexcept = delete;
+		Material& operator=(const Material&) = delete;
+		Material& operator=(Material&&) noexcept = delete;
+
+		//Nullptr when the diffuse map can't be loaded
+		//The other maps are optional, empty paths and maps with another size than the diffuse map are left out
+		static Material* LoadFromFiles(const std::string& diffusePath, const std::string& normalPath,
+			const std::string& glossPath, const std::string& specularPath);
+
+		MaterialSample Sample(const Vector2& uv) const;
+		MaterialSample Sample(const Vector2& uv, const TextureGradient& gradient) const; //Trilinear
+
+		bool HasNormalMap() const;
+
+	private:
+		//Same byte order as the MipTexture texels, red in the lowest byte
+		struct alignas(16) Texel
+		{
+			uint32_t diffuseGloss{}; //Gloss in the highest byte
+			uint32_t normal{};
+			uint32_t specular{};
+			uint32_t padding{};
+		};
+
+		Material(const MipTexture& diffuse, const MipTexture* pNormal, const MipTexture* pGloss, const MipTexture* pSpecular);
+
+		//Channels as bytes, or weighted sums of bytes, in the order of the record
+		static MaterialSample ToSample(const float channels[10]);
+
+		MipLayout m_Layout{};
+		std::vector<Texel> m_Texels{};
+		bool m_HasNormalMap{ false };
+	};
+}
@@ -0,0 +1,227 @@
+//Project includes
+#include "MeshCache.h"
+#include "MappedFile.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "Scene.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <type_traits>
+
+using namespace dae;
+
+namespace
+{
+	//Bump when the layout of the file changes
+	constexpr uint32_t g_Version{ 3 };
+	constexpr char g_Magic[4]{ 'R', 'M', 'S', 'H' };
+
+	//The vertices are used straight from the file
+	static_assert(std::is_trivially_copyable_v<Vertex>, "Vertex has to be trivially copyable to be stored in the mesh cache");
+	static_assert(std::is_trivially_copyable_v<MeshLod>, "MeshLod has to be trivially copyable to be stored in the mesh cache");
+
+	struct CacheHeader
+	{
+		char magic[4]{};
+		uint32_t version{};
+		uint32_t vertexSize{}; //sizeof(Vertex) of the build that wrote the cache
+		uint32_t primitiveTopology{};
+
+		//Key of the obj the cache was built from
+		uint64_t sourceSize{};
+		int64_t sourceWriteTime{};
+		uint64_t sourceHash{};
+
+		uint64_t nrVertices{};
+		uint64_t nrIndices{}; //Of all the levels of detail
+		uint64_t nrLods{}; //Stored after the indices
+	};
+	//Keeps the vertices after the header aligned
+	static_assert(sizeof(CacheHeader) == 64);
+
+	struct SourceKey
+	{
+		uint64_t size{};
+		int64_t writeTime{};
+	};
+
+	bool GetSourceKey(const std::string& objPath, SourceKey& key)
+	{
+		std::error_code error{};
+		key.size = std::filesystem::file_size(objPath, error);
+		if (error) return false;
+
+		key.writeTime = std::filesystem::last_write_time(objPath, error).time_since_epoch().count();
+		return !error;
+	}
+
+	//FNV-1a of the whole file, only calculated when the write time doesn't match anymore
+	uint64_t HashFile(const std::string& path)
+	{
+		std::ifstream file{ path, std::ios::binary };
+
+		uint64_t hash{ 14695981039346656037ull };
+		std::vector<char> chunk(1 << 20);
+		while (file)
+		{
+			file.read(chunk.data(), chunk.size());
+			const std::streamsize nrBytes{ file.gcount() };
+			for (std::streamsize i{ 0 }; i < nrBytes; ++i)
+			{
+				hash ^= static_cast<uint8_t>(chunk[i]);
+				hash *= 1099511628211ull;
+			}
+		}
+		return hash;
+	}
+
+	size_t GetExpectedFileSize(const CacheHeader& header)
+	{
+		return sizeof(CacheHeader) + header.nrVertices * sizeof(Vertex) + header.nrIndices * sizeof(uint32_t) + header.nrLods * sizeof(MeshLod);
+	}
+
+	//Every level has to stay inside of the stored indices and vertices, a corrupted one would be read past them
+	bool AreLodsValid(const CacheHeader& header, const std::span<const MeshLod> lods)
+	{
+		return std::all_of(lods.begin(), lods.end(), [&header](const MeshLod& lod)
+			{
+				return uint64_t{ lod.firstIndex } + lod.nrIndices <= header.nrIndices
+					&& lod.nrIndices % 3 == 0
+					&& lod.nrVertices <= header.nrVertices;
+			});
+	}
+
+	bool ReadHeader(const std::string& cachePath, CacheHeader& header)
+	{
+		std::ifstream file{ cachePath, std::ios::binary };
+		if (!file.read(reinterpret_cast<char*>(&header), sizeof(CacheHeader))) return false;
+
+		return std::equal(std::begin(g_Magic), std::end(g_Magic), header.magic)
+			&& header.version == g_Version
+			&& header.vertexSize == sizeof(Vertex);
+	}
+
+	//The obj was only touched, store its new write time so the next launch doesn't hash it again
+	void UpdateWriteTime(const std::string& cachePath, CacheHeader& header, const SourceKey& key)
+	{
+		header.sourceWriteTime = key.writeTime;
+
+		std::fstream file{ cachePath, std::ios::binary | std::ios::in | std::ios::out };
+		file.write(reinterpret_cast<const char*>(&header), sizeof(CacheHeader));
+	}
+
+	bool MapCache(const std::string& cachePath, MeshData& mesh)
+	{
+		auto pMappedFile{ std::make_unique<const MappedFile>(cachePath) };
+		if (!pMappedFile->IsOpen() || pMappedFile->GetSize() < sizeof(CacheHeader)) return false;
+
+		const uint8_t* pData{ pMappedFile->GetData() };
+		CacheHeader header{};
+		std::memcpy(&header, pData, sizeof(CacheHeader));
+
+		//A truncated file is rebuilt
+		if (pMappedFile->GetSize() != GetExpectedFileSize(header)) return false;
+
+		const uint8_t* pVertices{ pData + sizeof(CacheHeader) };
+		const uint8_t* pIndices{ pVertices + header.nrVertices * sizeof(Vertex) };
+		const uint8_t* pLods{ pIndices + header.nrIndices * sizeof(uint32_t) };
+
+		//A few bytes, copied so every mesh keeps its levels the same way
+		std::vector<MeshLod> lods(header.nrLods);
+		std::memcpy(lods.data(), pLods, header.nrLods * sizeof(MeshLod));
+
+		//A corrupted or stale file is rebuilt like a truncated one
+		if (!AreLodsValid(header, lods)) return false;
+
+		mesh.vertices = { reinterpret_cast<const Vertex*>(pVertices), static_cast<size_t>(header.nrVertices) };
+		mesh.indices = { reinterpret_cast<const uint32_t*>(pIndices), static_cast<size_t>(header.nrIndices) };
+		mesh.primitiveTopology = static_cast<PrimitiveTopology>(header.primitiveTopology);
+		mesh.lods = std::move(lods);
+		mesh.pMappedFile = std::move(pMappedFile);
+		return true;
+	}
+
+	//Written next to the final file and renamed, so an interrupted write never leaves a broken cache
+	bool WriteCache(const std::string& cachePath, const MeshData& mesh, const SourceKey& key, const uint64_t sourceHash)
+	{
+		CacheHeader header{};
+		std::copy(std::begin(g_Magic), std::end(g_Magic), header.magic);
+		header.version = g_Version;
+		header.vertexSize = sizeof(Vertex);
+		header.primitiveTopology = static_cast<uint32_t>(mesh.primitiveTopology);
+		header.sourceSize = key.size;
+		header.sourceWriteTime = key.writeTime;
+		header.sourceHash = sourceHash;
+		header.nrVertices = mesh.vertices.size();
+		header.nrIndices = mesh.indices.size();
+		header.nrLods = mesh.lods.size();
+
+		const std::string temporaryPath{ cachePath + ".tmp" };
+		{
+			std::ofstream file{ temporaryPath, std::ios::binary };
+			file.write(reinterpret_cast<const char*>(&header), sizeof(CacheHeader));
+			file.write(reinterpret_cast<const char*>(mesh.vertices.data()), mesh.vertices.size_bytes());
+			file.write(reinterpret_cast<const char*>(mesh.indices.data()), mesh.indices.size_bytes());
+			file.write(reinterpret_cast<const char*>(mesh.lods.data()), mesh.lods.size() * sizeof(MeshLod));
+			if (!file) return false;
+		}
+
+		std::error_code error{};
+		std::filesystem::rename(temporaryPath, cachePath, error);
+		if (error) std::filesystem::remove(temporaryPath, error);
+		return !error;
+	}
+}
+
+bool MeshCache::LoadOBJ(const std::string& objPath, MeshData& mesh)
+{
+	const std::string cachePath{ GetCachePath(objPath) };
+
+	SourceKey key{};
+	const bool hasSource{ GetSourceKey(objPath, key) };
+
+	CacheHeader header{};
+	if (hasSource && ReadHeader(cachePath, header) && header.sourceSize == key.size)
+	{
+		//Same size but another write time, the content decides (e.g. after a checkout)
+		if (header.sourceWriteTime != key.writeTime && header.sourceHash == HashFile(objPath))
+		{
+			UpdateWriteTime(cachePath, header, key);
+		}
+
+		if (header.sourceWriteTime == key.writeTime && MapCache(cachePath, mesh)) return true;
+	}
+
+	//Parse the text file and rebuild the cache
+	std::vector<Vertex> vertices{};
+	std::vector<uint32_t> indices{};
+	if (!Utils::ParseOBJ(objPath, vertices, indices)) return false;
+
+	//Only done when the cache is rebuilt, the cache stores the optimized mesh
+	const MeshOptimizer::Report report{ MeshOptimizer::Optimize(vertices, indices) };
+	MeshOptimizer::PrintReport(objPath, report, std::cout);
+
+	//After the optimization, the levels reorder the vertices again so each of them uses a prefix
+	std::vector<MeshLod> lods{ MeshSimplifier::BuildLods(vertices, indices) };
+	MeshSimplifier::PrintReport(objPath, lods, std::cout);
+
+	mesh.SetStorage(std::move(vertices), std::move(indices));
+	mesh.lods = std::move(lods);
+	mesh.primitiveTopology = PrimitiveTopology::TriangleList;
+
+	if (!hasSource || !WriteCache(cachePath, mesh, key, HashFile(objPath)))
+	{
+		std::cout << "Could not write the mesh cache " << cachePath << std::endl;
+	}
+	return true;
+}
+
+std::string MeshCache::GetCachePath(const std::string& objPath)
+{
+	return objPath + ".meshcache";
+}
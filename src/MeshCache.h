@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+
+namespace dae
+{
+	struct MeshData;
+
+	//Binary copy of the parsed and optimized obj files, stored next to them as <name>.obj.meshcache
+	//The vertices and indices are stored exactly as MeshData uses them, so a valid cache is mapped in memory and used without copy
+	namespace MeshCache
+	{
+		//Uses the cache when it was built from the current obj, otherwise parses the obj and rebuilds the cache
+		bool LoadOBJ(const std::string& objPath, MeshData& mesh);
+
+		std::string GetCachePath(const std::string& objPath);
+	}
+}
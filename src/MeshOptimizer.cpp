@@ -0,0 +1,301 @@
+//Project includes
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <type_traits>
+#include <unordered_map>
+
+using namespace dae;
+
+namespace
+{
+	//The vertices are compared and hashed as bytes
+	static_assert(std::is_trivially_copyable_v<Vertex>, "Vertex has to be trivially copyable to be deduplicated");
+	static_assert(sizeof(Vertex) % sizeof(float) == 0, "Vertex can't have padding bytes");
+
+	//Everything but the tangent, which is merged
+	Vertex GetDeduplicationKey(const Vertex& vertex)
+	{
+		Vertex key{ vertex };
+		key.tangent = Vector3{};
+		return key;
+	}
+
+	struct VertexHash
+	{
+		size_t operator()(const Vertex& vertex) const
+		{
+			//FNV-1a
+			const uint8_t* pBytes{ reinterpret_cast<const uint8_t*>(&vertex) };
+			uint64_t hash{ 14695981039346656037ull };
+			for (size_t i{ 0 }; i < sizeof(Vertex); ++i)
+			{
+				hash ^= pBytes[i];
+				hash *= 1099511628211ull;
+			}
+			return static_cast<size_t>(hash);
+		}
+	};
+
+	struct VertexEqual
+	{
+		bool operator()(const Vertex& a, const Vertex& b) const
+		{
+			return std::memcmp(&a, &b, sizeof(Vertex)) == 0;
+		}
+	};
+
+	//Scores of Tom Forsyth's "Linear-speed vertex cache optimisation"
+	constexpr float g_CacheDecayPower{ 1.5f };
+	constexpr float g_LastTriangleScore{ 0.75f };
+	constexpr float g_ValenceBoostScale{ 2.0f };
+	constexpr float g_ValenceBoostPower{ 0.5f };
+
+	float GetVertexScore(const int cachePosition, const uint32_t nrRemainingTriangles)
+	{
+		//Nothing left to draw with this vertex
+		if (nrRemainingTriangles == 0) return -1.0f;
+
+		float score{ 0.0f };
+		if (cachePosition >= 0)
+		{
+			//Used by the last triangle, drawing a triangle right next to it again doesn't help the cache as much
+			if (cachePosition < 3) score = g_LastTriangleScore;
+			else
+			{
+				const float scale{ 1.0f / (MeshOptimizer::cacheSize - 3) };
+				score = std::pow(1.0f - (cachePosition - 3) * scale, g_CacheDecayPower);
+			}
+		}
+
+		//Finish the vertices with few triangles left first, so they can leave the cache
+		score += g_ValenceBoostScale * std::pow(static_cast<float>(nrRemainingTriangles), -g_ValenceBoostPower);
+		return score;
+	}
+}
+
+MeshOptimizer::Report MeshOptimizer::Optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	Report report{};
+	report.nrVerticesBefore = vertices.size();
+	report.acmrBefore = GetACMR(indices, vertices.size());
+
+	DeduplicateVertices(vertices, indices);
+	report.acmrDeduplicated = GetACMR(indices, vertices.size());
+
+	OptimizeVertexCache(indices, vertices.size());
+	OptimizeVertexFetch(vertices, indices);
+	report.nrVerticesAfter = vertices.size();
+	report.acmrAfter = GetACMR(indices, vertices.size());
+	return report;
+}
+
+void MeshOptimizer::PrintReport(const std::string& name, const Report& report, std::ostream& stream)
+{
+	stream << "Optimized " << name << ": " << report.nrVerticesBefore << " -> " << report.nrVerticesAfter << " vertices" << std::endl;
+	stream << std::fixed << std::setprecision(3);
+	stream << "  ACMR (" << cacheSize << " entries) parsed / deduplicated / reordered: "
+		<< report.acmrBefore << " / " << report.acmrDeduplicated << " / " << report.acmrAfter << std::endl;
+	stream << std::defaultfloat;
+}
+
+void MeshOptimizer::DeduplicateVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	std::unordered_map<Vertex, uint32_t, VertexHash, VertexEqual> uniqueVertices{};
+	uniqueVertices.reserve(vertices.size());
+
+	std::vector<uint32_t> remap(vertices.size());
+	std::vector<Vertex> newVertices{};
+	std::vector<Vector3> tangentSums{};
+	for (size_t i{ 0 }; i < vertices.size(); ++i)
+	{
+		const auto [it, isNew] { uniqueVertices.try_emplace(GetDeduplicationKey(vertices[i]), static_cast<uint32_t>(newVertices.size())) };
+		if (isNew)
+		{
+			newVertices.push_back(vertices[i]);
+			tangentSums.push_back(Vector3{});
+		}
+		remap[i] = it->second;
+		tangentSums[it->second] += vertices[i].tangent;
+	}
+
+	//Same as the obj parser does for the corners of a single triangle
+	for (size_t i{ 0 }; i < newVertices.size(); ++i)
+	{
+		Vertex& vertex{ newVertices[i] };
+		const Vector3 tangent{ Vector3::Reject(tangentSums[i], vertex.normal) };
+
+		//Opposite tangents cancel out, keep the one of the first corner then
+		if (tangent.SqrMagnitude() > 1e-12f) vertex.tangent = tangent.Normalized();
+	}
+
+	for (uint32_t& index : indices)
+	{
+		index = remap[index];
+	}
+	vertices = std::move(newVertices);
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, const size_t nrVertices)
+{
+	const size_t nrTriangles{ indices.size() / 3 };
+	if (nrTriangles == 0) return;
+
+	//Triangles of every vertex, the ones not drawn yet come first
+	std::vector<uint32_t> triangleOffsets(nrVertices + 1);
+	for (const uint32_t index : indices)
+	{
+		++triangleOffsets[index + 1];
+	}
+	for (size_t vertex{ 0 }; vertex < nrVertices; ++vertex)
+	{
+		triangleOffsets[vertex + 1] += triangleOffsets[vertex];
+	}
+
+	std::vector<uint32_t> vertexTriangles(indices.size());
+	std::vector<uint32_t> nrRemainingTriangles(nrVertices);
+	for (size_t triangle{ 0 }; triangle < nrTriangles; ++triangle)
+	{
+		for (int i{ 0 }; i < 3; ++i)
+		{
+			const uint32_t vertex{ indices[3 * triangle + i] };
+			vertexTriangles[triangleOffsets[vertex] + nrRemainingTriangles[vertex]++] = static_cast<uint32_t>(triangle);
+		}
+	}
+
+	std::vector<int> cachePositions(nrVertices, -1);
+	std::vector<float> vertexScores(nrVertices);
+	for (size_t vertex{ 0 }; vertex < nrVertices; ++vertex)
+	{
+		vertexScores[vertex] = GetVertexScore(-1, nrRemainingTriangles[vertex]);
+	}
+
+	const auto getTriangleScore = [&](const size_t triangle)
+		{
+			return vertexScores[indices[3 * triangle]] + vertexScores[indices[3 * triangle + 1]] + vertexScores[indices[3 * triangle + 2]];
+		};
+
+	//Start with the best triangle of the whole mesh
+	size_t bestTriangle{ 0 };
+	for (size_t triangle{ 1 }; triangle < nrTriangles; ++triangle)
+	{
+		if (getTriangleScore(triangle) > getTriangleScore(bestTriangle)) bestTriangle = triangle;
+	}
+
+	std::vector<bool> isDrawn(nrTriangles);
+	size_t nextUndrawnTriangle{ 0 }; //Used when no triangle around the cache is left
+
+	std::vector<uint32_t> newIndices{};
+	newIndices.reserve(indices.size());
+
+	//The triangle being drawn is pushed in front, the ones pushed past cacheSize leave the cache
+	uint32_t cache[cacheSize + 3]{};
+	uint32_t newCache[cacheSize + 3]{};
+	int nrCached{ 0 };
+
+	while (newIndices.size() < indices.size())
+	{
+		const uint32_t* pTriangle{ &indices[3 * bestTriangle] };
+		isDrawn[bestTriangle] = true;
+
+		int nrNewCached{ 0 };
+		for (int i{ 0 }; i < 3; ++i)
+		{
+			const uint32_t vertex{ pTriangle[i] };
+			newIndices.push_back(vertex);
+
+			//Move the triangle behind the ones still to draw
+			uint32_t* pVertexTriangles{ &vertexTriangles[triangleOffsets[vertex]] };
+			uint32_t& nrRemaining{ nrRemainingTriangles[vertex] };
+			std::swap(*std::find(pVertexTriangles, pVertexTriangles + nrRemaining, static_cast<uint32_t>(bestTriangle)), pVertexTriangles[nrRemaining - 1]);
+			--nrRemaining;
+
+			if (std::find(newCache, newCache + nrNewCached, vertex) == newCache + nrNewCached) newCache[nrNewCached++] = vertex;
+		}
+		for (int i{ 0 }; i < nrCached; ++i)
+		{
+			if (std::find(pTriangle, pTriangle + 3, cache[i]) == pTriangle + 3) newCache[nrNewCached++] = cache[i];
+		}
+
+		nrCached = std::min(nrNewCached, cacheSize);
+		std::copy_n(newCache, nrCached, cache);
+		for (int i{ 0 }; i < nrNewCached; ++i)
+		{
+			const uint32_t vertex{ newCache[i] };
+			cachePositions[vertex] = i < nrCached ? i : -1;
+			vertexScores[vertex] = GetVertexScore(cachePositions[vertex], nrRemainingTriangles[vertex]);
+		}
+
+		//Only the triangles of the vertices that moved in the cache change score, the best of the cached ones is drawn next
+		float bestScore{ -std::numeric_limits<float>::max() };
+		bool hasCandidate{ false };
+		for (int i{ 0 }; i < nrCached; ++i)
+		{
+			const uint32_t vertex{ cache[i] };
+			const uint32_t* pVertexTriangles{ &vertexTriangles[triangleOffsets[vertex]] };
+			for (uint32_t j{ 0 }; j < nrRemainingTriangles[vertex]; ++j)
+			{
+				const float score{ getTriangleScore(pVertexTriangles[j]) };
+				if (score > bestScore)
+				{
+					bestScore = score;
+					bestTriangle = pVertexTriangles[j];
+					hasCandidate = true;
+				}
+			}
+		}
+
+		if (!hasCandidate && newIndices.size() < indices.size())
+		{
+			//Nothing left around the cache, continue where the original order is
+			while (isDrawn[nextUndrawnTriangle]) ++nextUndrawnTriangle;
+			bestTriangle = nextUndrawnTriangle;
+		}
+	}
+
+	indices = std::move(newIndices);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	constexpr uint32_t unused{ std::numeric_limits<uint32_t>::max() };
+	std::vector<uint32_t> remap(vertices.size(), unused);
+
+	std::vector<Vertex> newVertices{};
+	newVertices.reserve(vertices.size());
+	for (uint32_t& index : indices)
+	{
+		if (remap[index] == unused)
+		{
+			remap[index] = static_cast<uint32_t>(newVertices.size());
+			newVertices.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+
+	vertices = std::move(newVertices);
+}
+
+float MeshOptimizer::GetACMR(const std::span<const uint32_t> indices, const size_t nrVertices)
+{
+	if (indices.size() < 3) return 0.0f;
+
+	//A vertex is still cached when less than cacheSize vertices were added after it
+	std::vector<uint32_t> insertionTimes(nrVertices, 0);
+	uint32_t time{ cacheSize + 1 };
+	size_t nrMisses{ 0 };
+	for (const uint32_t index : indices)
+	{
+		if (time - insertionTimes[index] > cacheSize)
+		{
+			insertionTimes[index] = time++;
+			++nrMisses;
+		}
+	}
+
+	return static_cast<float>(nrMisses) / (indices.size() / 3);
+}
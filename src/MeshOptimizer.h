@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "DataTypes.h"
+
+namespace dae
+{
+	//Load time optimization of the triangle lists, done once before the mesh cache is written
+	//The triangles are reordered so the vertices they share are still in the cache, and the vertices so they are read in order
+	namespace MeshOptimizer
+	{
+		//Entries of the simulated post transform vertex cache
+		constexpr int cacheSize{ 32 };
+
+		struct Report
+		{
+			size_t nrVerticesBefore{};
+			size_t nrVerticesAfter{};
+
+			//Average cache miss ratio, see GetACMR
+			float acmrBefore{};
+			float acmrDeduplicated{};
+			float acmrAfter{};
+		};
+
+		//Runs the three passes below and measures them
+		Report Optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+		void PrintReport(const std::string& name, const Report& report, std::ostream& stream);
+
+		//Merge the vertices with the same position, color, uv, normal and view direction
+		//The obj parser gives every corner its own tangent, the merged vertex uses the average one
+		void DeduplicateVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+		//Reorder the triangles with Forsyth's linear speed vertex cache optimization, the winding is kept
+		void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t nrVertices);
+
+		//Reorder the vertices by their first use, the unused ones are removed
+		void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+		//Transformed vertices per triangle with a FIFO cache of cacheSize entries
+		//3 when no vertex is shared, around 0.5 for a large regular grid in the best order
+		float GetACMR(std::span<const uint32_t> indices, size_t nrVertices);
+	}
+}
@@ -0,0 +1,573 @@
+//Project includes
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include "Scene.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+using namespace dae;
+
+namespace
+{
+	//Every level has this part of the triangles of the level before
+	constexpr float g_LodReduction{ 0.5f };
+	//A level that doesn't remove at least this part of the triangles isn't worth its memory, the chain stops
+	constexpr float g_MinLodReduction{ 0.2f };
+	constexpr size_t g_MinLodTriangles{ 64 };
+	//Largest error of a level as part of the diagonal of the mesh, a mesh that small on screen is only a few pixels wide
+	constexpr float g_MaxLodError{ 0.05f };
+
+	//The planes along the borders and seams count more than the ones of the triangles, so they don't shrink
+	constexpr double g_BorderWeight{ 10.0 };
+	//A collapse can't turn a triangle more than about 75 degrees, that is folding the surface
+	constexpr float g_MinNormalCosine{ 0.25f };
+	//Collapses of a pass can cost up to this times the cost of the last one needed to reach the target
+	constexpr double g_PassErrorScale{ 1.5 };
+
+	//Sum of the squared distances to a set of planes, v^T A v + 2 b.v + c, see Garland and Heckbert
+	struct Quadric
+	{
+		double a00{};
+		double a01{};
+		double a02{};
+		double a11{};
+		double a12{};
+		double a22{};
+		double b0{};
+		double b1{};
+		double b2{};
+		double c{};
+		double weight{}; //Of all the planes
+
+		//The plane dot(normal, point) + distance = 0, the normal is normalized
+		void AddPlane(const Vector3& normal, const float distance, const double planeWeight)
+		{
+			const double x{ normal.x };
+			const double y{ normal.y };
+			const double z{ normal.z };
+			const double d{ distance };
+			a00 += planeWeight * x * x;
+			a01 += planeWeight * x * y;
+			a02 += planeWeight * x * z;
+			a11 += planeWeight * y * y;
+			a12 += planeWeight * y * z;
+			a22 += planeWeight * z * z;
+			b0 += planeWeight * x * d;
+			b1 += planeWeight * y * d;
+			b2 += planeWeight * z * d;
+			c += planeWeight * d * d;
+			weight += planeWeight;
+		}
+
+		Quadric& operator+=(const Quadric& other)
+		{
+			a00 += other.a00;
+			a01 += other.a01;
+			a02 += other.a02;
+			a11 += other.a11;
+			a12 += other.a12;
+			a22 += other.a22;
+			b0 += other.b0;
+			b1 += other.b1;
+			b2 += other.b2;
+			c += other.c;
+			weight += other.weight;
+			return *this;
+		}
+
+		//Mean of the squared distances, a big flat area doesn't cost more than a small one
+		double GetError(const Vector3& point) const
+		{
+			if (weight == 0.0) return 0.0;
+
+			const double x{ point.x };
+			const double y{ point.y };
+			const double z{ point.z };
+			const double error{ x * (a00 * x + a01 * y + a02 * z) + y * (a01 * x + a11 * y + a12 * z) + z * (a02 * x + a12 * y + a22 * z)
+				+ 2.0 * (b0 * x + b1 * y + b2 * z) + c };
+
+			//Rounding can make it a bit negative
+			return std::max(error, 0.0) / weight;
+		}
+	};
+
+	enum struct VertexKind : uint8_t
+	{
+		Manifold, //Can collapse along any edge
+		Border, //On the open border of the surface, only along the border
+		Seam, //Where two vertices with the same position but other attributes meet, only along the seam
+		Locked //Corner of a border or seam, or on a non manifold edge, never moves
+	};
+
+	enum struct EdgeKind : uint8_t
+	{
+		Interior,
+		Border,
+		Seam,
+		NonManifold
+	};
+
+	uint64_t GetEdgeKey(const uint32_t a, const uint32_t b)
+	{
+		return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+	}
+
+	//Every vertex points to the first vertex with the exact same position, the seams are between vertices that share it
+	std::vector<uint32_t> GetPositionIds(const std::span<const Vertex> vertices)
+	{
+		struct PositionHash
+		{
+			size_t operator()(const Vector3& position) const
+			{
+				const std::hash<float> hash{};
+				return hash(position.x) ^ (hash(position.y) * 31) ^ (hash(position.z) * 961);
+			}
+		};
+		struct PositionEqual
+		{
+			bool operator()(const Vector3& a, const Vector3& b) const
+			{
+				return a.x == b.x && a.y == b.y && a.z == b.z;
+			}
+		};
+
+		std::unordered_map<Vector3, uint32_t, PositionHash, PositionEqual> firstVertices{};
+		firstVertices.reserve(vertices.size());
+
+		std::vector<uint32_t> positionIds(vertices.size());
+		for (size_t vertex{ 0 }; vertex < vertices.size(); ++vertex)
+		{
+			positionIds[vertex] = firstVertices.try_emplace(vertices[vertex].position, static_cast<uint32_t>(vertex)).first->second;
+		}
+		return positionIds;
+	}
+
+	//Not normalized, its length is twice the area
+	Vector3 GetTriangleNormal(const Vector3& a, const Vector3& b, const Vector3& c)
+	{
+		return Vector3::Cross(b - a, c - a);
+	}
+
+	//Topology of the triangles that are left, rebuilt after every pass
+	struct Adjacency
+	{
+		//Triangles around every position, position p has the ones in [offsets[p], offsets[p + 1][
+		std::vector<uint32_t> triangleOffsets{};
+		std::vector<uint32_t> triangles{};
+
+		std::unordered_map<uint64_t, EdgeKind> edgeKinds{};
+		std::vector<VertexKind> vertexKinds{};
+	};
+
+	void BuildAdjacency(std::span<const uint32_t> indices, std::span<const uint32_t> positionIds, Adjacency& adjacency)
+	{
+		const size_t nrVertices{ positionIds.size() };
+		const size_t nrTriangles{ indices.size() / 3 };
+
+		adjacency.triangleOffsets.assign(nrVertices + 1, 0);
+		for (const uint32_t index : indices)
+		{
+			++adjacency.triangleOffsets[positionIds[index] + 1];
+		}
+		std::partial_sum(adjacency.triangleOffsets.begin(), adjacency.triangleOffsets.end(), adjacency.triangleOffsets.begin());
+
+		std::vector<uint32_t> nrAdded(nrVertices, 0);
+		adjacency.triangles.resize(indices.size());
+		for (size_t triangle{ 0 }; triangle < nrTriangles; ++triangle)
+		{
+			for (int corner{ 0 }; corner < 3; ++corner)
+			{
+				const uint32_t position{ positionIds[indices[3 * triangle + corner]] };
+				adjacency.triangles[adjacency.triangleOffsets[position] + nrAdded[position]++] = static_cast<uint32_t>(triangle);
+			}
+		}
+
+		//An edge used by two triangles is a seam when they don't use the same two vertices for it
+		std::unordered_map<uint64_t, uint32_t> positionEdgeCounts{};
+		std::unordered_map<uint64_t, uint32_t> vertexEdgeCounts{};
+		positionEdgeCounts.reserve(indices.size());
+		vertexEdgeCounts.reserve(indices.size());
+		for (size_t triangle{ 0 }; triangle < nrTriangles; ++triangle)
+		{
+			for (int corner{ 0 }; corner < 3; ++corner)
+			{
+				const uint32_t a{ indices[3 * triangle + corner] };
+				const uint32_t b{ indices[3 * triangle + (corner + 1) % 3] };
+				++positionEdgeCounts[GetEdgeKey(positionIds[a], positionIds[b])];
+				++vertexEdgeCounts[GetEdgeKey(a, b)];
+			}
+		}
+
+		adjacency.edgeKinds.clear();
+		adjacency.edgeKinds.reserve(positionEdgeCounts.size());
+		std::vector<uint32_t> nrBorderEdges(nrVertices, 0);
+		std::vector<uint32_t> nrSeamEdges(nrVertices, 0);
+		std::vector<bool> isNonManifold(nrVertices, false);
+		for (size_t triangle{ 0 }; triangle < nrTriangles; ++triangle)
+		{
+			for (int corner{ 0 }; corner < 3; ++corner)
+			{
+				const uint32_t a{ indices[3 * triangle + corner] };
+				const uint32_t b{ indices[3 * triangle + (corner + 1) % 3] };
+				const uint32_t positionA{ positionIds[a] };
+				const uint32_t positionB{ positionIds[b] };
+				const uint64_t key{ GetEdgeKey(positionA, positionB) };
+				const uint32_t nrEdgeTriangles{ positionEdgeCounts[key] };
+
+				EdgeKind kind{ EdgeKind::Interior };
+				if (nrEdgeTriangles == 1) kind = EdgeKind::Border;
+				else if (nrEdgeTriangles > 2) kind = EdgeKind::NonManifold;
+				else if (vertexEdgeCounts[GetEdgeKey(a, b)] == 1) kind = EdgeKind::Seam;
+				adjacency.edgeKinds[key] = kind;
+
+				//Seen once for a border and twice for a seam, from both of its triangles
+				switch (kind)
+				{
+				case EdgeKind::Border:
+					++nrBorderEdges[positionA];
+					++nrBorderEdges[positionB];
+					break;
+				case EdgeKind::Seam:
+					++nrSeamEdges[positionA];
+					++nrSeamEdges[positionB];
+					break;
+				case EdgeKind::NonManifold:
+					isNonManifold[positionA] = true;
+					isNonManifold[positionB] = true;
+					break;
+				default:
+					break;
+				}
+			}
+		}
+
+		//A border or seam that doesn't just pass through the vertex can't be kept when it moves
+		adjacency.vertexKinds.assign(nrVertices, VertexKind::Manifold);
+		for (size_t position{ 0 }; position < nrVertices; ++position)
+		{
+			VertexKind& kind{ adjacency.vertexKinds[position] };
+			if (isNonManifold[position] || (nrBorderEdges[position] && nrSeamEdges[position])) kind = VertexKind::Locked;
+			else if (nrBorderEdges[position]) kind = nrBorderEdges[position] == 2 ? VertexKind::Border : VertexKind::Locked;
+			else if (nrSeamEdges[position]) kind = nrSeamEdges[position] == 4 ? VertexKind::Seam : VertexKind::Locked;
+		}
+	}
+
+	//Planes of the triangles, and planes through the borders and seams perpendicular to their triangle
+	std::vector<Quadric> GetQuadrics(std::span<const Vertex> vertices, std::span<const uint32_t> indices, std::span<const uint32_t> positionIds, const Adjacency& adjacency)
+	{
+		std::vector<Quadric> quadrics(vertices.size());
+		for (size_t triangle{ 0 }; triangle < indices.size() / 3; ++triangle)
+		{
+			const uint32_t* pTriangle{ &indices[3 * triangle] };
+			const Vector3 normal{ GetTriangleNormal(vertices[pTriangle[0]].position, vertices[pTriangle[1]].position, vertices[pTriangle[2]].position) };
+			const float length{ normal.Magnitude() };
+			if (length == 0.0f) continue;
+
+			const Vector3 unitNormal{ normal / length };
+			Quadric quadric{};
+			quadric.AddPlane(unitNormal, -Vector3::Dot(unitNormal, vertices[pTriangle[0]].position), 1.0);
+			for (int corner{ 0 }; corner < 3; ++corner)
+			{
+				quadrics[positionIds[pTriangle[corner]]] += quadric;
+			}
+
+			for (int corner{ 0 }; corner < 3; ++corner)
+			{
+				const uint32_t positionA{ positionIds[pTriangle[corner]] };
+				const uint32_t positionB{ positionIds[pTriangle[(corner + 1) % 3]] };
+				const EdgeKind kind{ adjacency.edgeKinds.at(GetEdgeKey(positionA, positionB)) };
+				if (kind != EdgeKind::Border && kind != EdgeKind::Seam) continue;
+
+				const Vector3 edge{ vertices[positionB].position - vertices[positionA].position };
+				const Vector3 edgeNormal{ Vector3::Cross(edge, unitNormal) };
+				const float edgeLength{ edgeNormal.Magnitude() };
+				if (edgeLength == 0.0f) continue;
+
+				Quadric edgeQuadric{};
+				const Vector3 unitEdgeNormal{ edgeNormal / edgeLength };
+				edgeQuadric.AddPlane(unitEdgeNormal, -Vector3::Dot(unitEdgeNormal, vertices[positionA].position), g_BorderWeight);
+				quadrics[positionA] += edgeQuadric;
+				quadrics[positionB] += edgeQuadric;
+			}
+		}
+		return quadrics;
+	}
+
+	//Every position moves to the neighbor it costs the least to move to, when it is allowed to move
+	struct Collapse
+	{
+		uint32_t source{};
+		uint32_t target{};
+		double error{};
+	};
+
+	std::vector<Collapse> GetCollapses(std::span<const Vertex> vertices, std::span<const uint32_t> indices, std::span<const uint32_t> positionIds,
+		const Adjacency& adjacency, std::span<const Quadric> quadrics)
+	{
+		constexpr uint32_t none{ std::numeric_limits<uint32_t>::max() };
+		std::vector<Collapse> bestCollapses(vertices.size(), Collapse{ none, none, std::numeric_limits<double>::max() });
+
+		const auto tryCollapse = [&](const uint32_t source, const uint32_t target, const EdgeKind edgeKind)
+			{
+				const VertexKind kind{ adjacency.vertexKinds[source] };
+				const bool isAllowed{ kind == VertexKind::Manifold
+					|| (kind == VertexKind::Border && edgeKind == EdgeKind::Border)
+					|| (kind == VertexKind::Seam && edgeKind == EdgeKind::Seam) };
+				if (!isAllowed) return;
+
+				Quadric quadric{ quadrics[source] };
+				quadric += quadrics[target];
+				const double error{ quadric.GetError(vertices[target].position) };
+				if (error < bestCollapses[source].error) bestCollapses[source] = { source, target, error };
+			};
+
+		for (size_t triangle{ 0 }; triangle < indices.size() / 3; ++triangle)
+		{
+			for (int corner{ 0 }; corner < 3; ++corner)
+			{
+				const uint32_t positionA{ positionIds[indices[3 * triangle + corner]] };
+				const uint32_t positionB{ positionIds[indices[3 * triangle + (corner + 1) % 3]] };
+				const EdgeKind edgeKind{ adjacency.edgeKinds.at(GetEdgeKey(positionA, positionB)) };
+				tryCollapse(positionA, positionB, edgeKind);
+				tryCollapse(positionB, positionA, edgeKind);
+			}
+		}
+
+		std::vector<Collapse> collapses{};
+		for (const Collapse& collapse : bestCollapses)
+		{
+			if (collapse.source != none) collapses.push_back(collapse);
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+		return collapses;
+	}
+
+	//Moves the source position onto the target, every vertex of the source takes the vertex of the target on the same side of the seam
+	//Returns the number of triangles removed, 0 when the collapse isn't valid
+	size_t TryCollapse(const Collapse& collapse, std::span<const Vertex> vertices, std::vector<uint32_t>& indices, std::span<const uint32_t> positionIds,
+		const Adjacency& adjacency, std::vector<std::pair<uint32_t, uint32_t>>& vertexRemap)
+	{
+		const std::span<const uint32_t> triangles{ adjacency.triangles.data() + adjacency.triangleOffsets[collapse.source],
+			adjacency.triangleOffsets[collapse.source + 1] - adjacency.triangleOffsets[collapse.source] };
+		const Vector3& targetPosition{ vertices[collapse.target].position };
+
+		vertexRemap.clear();
+		const auto findRemap = [&vertexRemap](const uint32_t vertex)
+			{
+				return std::find_if(vertexRemap.begin(), vertexRemap.end(), [vertex](const auto& remap) { return remap.first == vertex; });
+			};
+
+		//The triangles on the edge tell which vertex of the target every vertex of the source becomes
+		size_t nrRemovedTriangles{ 0 };
+		for (const uint32_t triangle : triangles)
+		{
+			const uint32_t* pTriangle{ &indices[3 * triangle] };
+			int sourceCorner{ -1 };
+			int targetCorner{ -1 };
+			for (int corner{ 0 }; corner < 3; ++corner)
+			{
+				const uint32_t position{ positionIds[pTriangle[corner]] };
+				if (position == collapse.source) sourceCorner = corner;
+				else if (position == collapse.target) targetCorner = corner;
+			}
+			if (targetCorner < 0) continue;
+
+			const auto it{ findRemap(pTriangle[sourceCorner]) };
+			if (it == vertexRemap.end()) vertexRemap.emplace_back(pTriangle[sourceCorner], pTriangle[targetCorner]);
+			else if (it->second != pTriangle[targetCorner]) return 0;
+			++nrRemovedTriangles;
+		}
+		if (nrRemovedTriangles == 0) return 0;
+
+		//Every vertex of the source needs a vertex of the target, or the seam would tear
+		//The other triangles can't fold over
+		for (const uint32_t triangle : triangles)
+		{
+			const uint32_t* pTriangle{ &indices[3 * triangle] };
+			Vector3 positions[3]{};
+			int sourceCorner{ -1 };
+			bool hasTarget{ false };
+			for (int corner{ 0 }; corner < 3; ++corner)
+			{
+				const uint32_t position{ positionIds[pTriangle[corner]] };
+				positions[corner] = vertices[position].position;
+				if (position == collapse.source) sourceCorner = corner;
+				hasTarget |= position == collapse.target;
+			}
+			if (findRemap(pTriangle[sourceCorner]) == vertexRemap.end()) return 0;
+			if (hasTarget) continue;
+
+			const Vector3 normal{ GetTriangleNormal(positions[0], positions[1], positions[2]) };
+			positions[sourceCorner] = targetPosition;
+			const Vector3 newNormal{ GetTriangleNormal(positions[0], positions[1], positions[2]) };
+			if (Vector3::Dot(normal, newNormal) < g_MinNormalCosine * normal.Magnitude() * newNormal.Magnitude()) return 0;
+		}
+
+		for (const uint32_t triangle : triangles)
+		{
+			uint32_t* pTriangle{ &indices[3 * triangle] };
+			for (int corner{ 0 }; corner < 3; ++corner)
+			{
+				if (positionIds[pTriangle[corner]] == collapse.source) pTriangle[corner] = findRemap(pTriangle[corner])->second;
+			}
+		}
+		return nrRemovedTriangles;
+	}
+
+	//Triangles with two corners at the same position are left by the collapses
+	void RemoveDegenerateTriangles(std::vector<uint32_t>& indices, std::span<const uint32_t> positionIds)
+	{
+		size_t nrIndices{ 0 };
+		for (size_t index{ 0 }; index < indices.size(); index += 3)
+		{
+			const uint32_t a{ positionIds[indices[index]] };
+			const uint32_t b{ positionIds[indices[index + 1]] };
+			const uint32_t c{ positionIds[indices[index + 2]] };
+			if (a == b || b == c || c == a) continue;
+
+			indices[nrIndices++] = indices[index];
+			indices[nrIndices++] = indices[index + 1];
+			indices[nrIndices++] = indices[index + 2];
+		}
+		indices.resize(nrIndices);
+	}
+}
+
+std::vector<MeshLod> MeshSimplifier::BuildLods(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	BoundingBox bounds{};
+	for (const Vertex& vertex : vertices)
+	{
+		bounds.Add(vertex.position);
+	}
+	const float maxError{ bounds.IsEmpty() ? 0.0f : bounds.GetSize().Magnitude() * g_MaxLodError };
+
+	std::vector<std::vector<uint32_t>> levels{};
+	std::vector<float> errors{};
+	levels.push_back(indices);
+	errors.push_back(0.0f);
+
+	while (levels.size() < maxNrLods)
+	{
+		const size_t nrTriangles{ levels.back().size() / 3 };
+		if (nrTriangles < g_MinLodTriangles) break;
+
+		//Every level starts from the one before, the errors add up
+		float error{};
+		std::vector<uint32_t> level{ Simplify(vertices, levels.back(), static_cast<size_t>(nrTriangles * g_LodReduction), maxError - errors.back(), error) };
+		if (level.size() / 3 > nrTriangles * (1.0f - g_MinLodReduction)) break;
+
+		MeshOptimizer::OptimizeVertexCache(level, vertices.size());
+		errors.push_back(errors.back() + error);
+		levels.push_back(std::move(level));
+	}
+
+	//The vertices of the coarsest level first, every level only adds the ones it uses on top of the coarser ones
+	constexpr uint32_t unused{ std::numeric_limits<uint32_t>::max() };
+	std::vector<uint32_t> remap(vertices.size(), unused);
+	std::vector<Vertex> newVertices{};
+	newVertices.reserve(vertices.size());
+	std::vector<MeshLod> lods(levels.size());
+	for (size_t lod{ levels.size() }; lod-- > 0;)
+	{
+		for (uint32_t& index : levels[lod])
+		{
+			if (remap[index] == unused)
+			{
+				remap[index] = static_cast<uint32_t>(newVertices.size());
+				newVertices.push_back(vertices[index]);
+			}
+			index = remap[index];
+		}
+		lods[lod].nrVertices = static_cast<uint32_t>(newVertices.size());
+		lods[lod].error = errors[lod];
+	}
+	vertices = std::move(newVertices);
+
+	indices.clear();
+	for (size_t lod{ 0 }; lod < levels.size(); ++lod)
+	{
+		lods[lod].firstIndex = static_cast<uint32_t>(indices.size());
+		lods[lod].nrIndices = static_cast<uint32_t>(levels[lod].size());
+		indices.insert(indices.end(), levels[lod].begin(), levels[lod].end());
+	}
+	return lods;
+}
+
+void MeshSimplifier::PrintReport(const std::string& name, const std::span<const MeshLod> lods, std::ostream& stream)
+{
+	stream << "Levels of detail of " << name << ":" << std::endl;
+	for (size_t lod{ 0 }; lod < lods.size(); ++lod)
+	{
+		stream << "  LOD " << lod << ": " << lods[lod].nrIndices / 3 << " triangles, " << lods[lod].nrVertices << " vertices, error " << lods[lod].error << std::endl;
+	}
+}
+
+std::vector<uint32_t> MeshSimplifier::Simplify(const std::span<const Vertex> vertices, const std::span<const uint32_t> indices, const size_t targetNrTriangles,
+	const float maxError, float& error)
+{
+	const std::vector<uint32_t> positionIds{ GetPositionIds(vertices) };
+	std::vector<uint32_t> newIndices{ indices.begin(), indices.end() };
+	RemoveDegenerateTriangles(newIndices, positionIds);
+
+	Adjacency adjacency{};
+	BuildAdjacency(newIndices, positionIds, adjacency);
+
+	//Only built once, the quadric of a position that moved is added to the one of its target
+	std::vector<Quadric> quadrics{ GetQuadrics(vertices, newIndices, positionIds, adjacency) };
+
+	//The errors of the quadrics are squared distances
+	const double maxCollapseError{ static_cast<double>(maxError) * maxError };
+	double largestError{ 0.0 };
+	std::vector<bool> isTouched(vertices.size());
+	std::vector<std::pair<uint32_t, uint32_t>> vertexRemap{};
+	while (newIndices.size() / 3 > targetNrTriangles)
+	{
+		std::vector<Collapse> collapses{ GetCollapses(vertices, newIndices, positionIds, adjacency, quadrics) };
+		collapses.erase(std::find_if(collapses.begin(), collapses.end(), [maxCollapseError](const Collapse& collapse) { return collapse.error > maxCollapseError; }), collapses.end());
+		if (collapses.empty()) break;
+
+		//Most collapses remove two triangles, the ones that are much worse than needed wait for the next pass
+		const size_t nrTrianglesToRemove{ newIndices.size() / 3 - targetNrTriangles };
+		const size_t nrNeededCollapses{ std::min((nrTrianglesToRemove + 1) / 2, collapses.size()) };
+		const double maxPassError{ collapses[nrNeededCollapses - 1].error * g_PassErrorScale };
+
+		//The triangles around a collapse changed, their positions wait for the next pass
+		std::fill(isTouched.begin(), isTouched.end(), false);
+		size_t nrRemovedTriangles{ 0 };
+		for (const Collapse& collapse : collapses)
+		{
+			if (nrRemovedTriangles >= nrTrianglesToRemove || collapse.error > maxPassError) break;
+			if (isTouched[collapse.source] || isTouched[collapse.target]) continue;
+
+			const size_t nrRemoved{ TryCollapse(collapse, vertices, newIndices, positionIds, adjacency, vertexRemap) };
+			if (nrRemoved == 0) continue;
+			nrRemovedTriangles += nrRemoved;
+
+			quadrics[collapse.target] += quadrics[collapse.source];
+			largestError = std::max(largestError, collapse.error);
+
+			for (uint32_t i{ adjacency.triangleOffsets[collapse.source] }; i < adjacency.triangleOffsets[collapse.source + 1]; ++i)
+			{
+				const uint32_t* pTriangle{ &newIndices[3 * adjacency.triangles[i]] };
+				isTouched[positionIds[pTriangle[0]]] = true;
+				isTouched[positionIds[pTriangle[1]]] = true;
+				isTouched[positionIds[pTriangle[2]]] = true;
+			}
+			isTouched[collapse.source] = true;
+		}
+		if (nrRemovedTriangles == 0) break;
+
+		RemoveDegenerateTriangles(newIndices, positionIds);
+		BuildAdjacency(newIndices, positionIds, adjacency);
+	}
+
+	//Root mean square distance to the planes around the vertices that moved
+	error = static_cast<float>(std::sqrt(largestError));
+	return newIndices;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "DataTypes.h"
+
+namespace dae
+{
+	struct MeshLod;
+
+	//Load time levels of detail, done once before the mesh cache is written
+	//Every level is an index buffer on the same vertices, made by collapsing edges of the level before onto one of their vertices
+	namespace MeshSimplifier
+	{
+		//Levels including the full mesh
+		constexpr size_t maxNrLods{ 4 };
+
+		//Replaces indices by all the levels behind each other and reorders the vertices so every level uses a prefix of them
+		//Each level has about half the triangles of the one before, the chain stops early when the mesh can't be simplified anymore
+		std::vector<MeshLod> BuildLods(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+		void PrintReport(const std::string& name, std::span<const MeshLod> lods, std::ostream& stream);
+
+		//Quadric edge collapse of a triangle list until at most targetNrTriangles are left, or no collapse moves the surface less than maxError
+		//Vertices on a border only move along the border, and the ones on a uv or normal seam only along the seam
+		//Returns the new indices, error is set to how far the surface moved, the root mean square distance of the worst collapse in object space
+		std::vector<uint32_t> Simplify(std::span<const Vertex> vertices, std::span<const uint32_t> indices, size_t targetNrTriangles, float maxError, float& error);
+	}
+}
@@ -0,0 +1,253 @@
+//External includes
+#include "SDL.h"
+#include "SDL_image.h"
+
+//Project includes
+#include "MipTexture.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace dae;
+
+namespace
+{
+	//Spreads the 3 bits of a coordinate inside of a tile, y uses the odd bits
+	constexpr uint32_t g_MortonBits[8]{ 0, 1, 4, 5, 16, 17, 20, 21 };
+
+	uint32_t Pack(const uint32_t r, const uint32_t g, const uint32_t b)
+	{
+		return r | (g << 8) | (b << 16);
+	}
+	uint32_t GetChannel(const uint32_t texel, const int channel)
+	{
+		return (texel >> (channel * 8)) & 0xFF;
+	}
+
+	//Box filter of 2x2 texels, the last row and column are repeated for odd sizes
+	std::vector<uint32_t> Downsample(const std::vector<uint32_t>& texels, const int width, const int height, const bool isNormalMap)
+	{
+		const int newWidth{ std::max(width / 2, 1) };
+		const int newHeight{ std::max(height / 2, 1) };
+		std::vector<uint32_t> newTexels(static_cast<size_t>(newWidth) * newHeight);
+
+		for (int y{ 0 }; y < newHeight; ++y)
+		{
+			const int y0{ std::min(2 * y, height - 1) };
+			const int y1{ std::min(2 * y + 1, height - 1) };
+			for (int x{ 0 }; x < newWidth; ++x)
+			{
+				const int x0{ std::min(2 * x, width - 1) };
+				const int x1{ std::min(2 * x + 1, width - 1) };
+				const uint32_t source[4]{ texels[x0 + y0 * width], texels[x1 + y0 * width], texels[x0 + y1 * width], texels[x1 + y1 * width] };
+
+				uint32_t sum[3]{};
+				for (const uint32_t texel : source)
+				{
+					for (int channel{ 0 }; channel < 3; ++channel)
+					{
+						sum[channel] += GetChannel(texel, channel);
+					}
+				}
+
+				uint32_t& newTexel{ newTexels[x + y * newWidth] };
+				if (isNormalMap)
+				{
+					//Average of the directions, back to unit length so the lighting doesn't get darker at distance
+					Vector3 normal{ sum[0] / 510.0f - 1.0f, sum[1] / 510.0f - 1.0f, sum[2] / 510.0f - 1.0f };
+					const float length{ normal.Magnitude() };
+					if (length > 0) normal /= length;
+
+					newTexel = Pack(
+						static_cast<uint32_t>((normal.x * 0.5f + 0.5f) * 255 + 0.5f),
+						static_cast<uint32_t>((normal.y * 0.5f + 0.5f) * 255 + 0.5f),
+						static_cast<uint32_t>((normal.z * 0.5f + 0.5f) * 255 + 0.5f));
+				}
+				else
+				{
+					newTexel = Pack((sum[0] + 2) / 4, (sum[1] + 2) / 4, (sum[2] + 2) / 4);
+				}
+			}
+		}
+
+		return newTexels;
+	}
+}
+
+MipTexture* MipTexture::LoadFromFile(const std::string& path, const bool isNormalMap)
+{
+	SDL_Surface* pSurface{ IMG_Load(path.c_str()) };
+	if (!pSurface) return nullptr;
+
+	const int width{ pSurface->w };
+	const int height{ pSurface->h };
+	std::vector<uint32_t> texels(static_cast<size_t>(width) * height);
+
+	for (int y{ 0 }; y < height; ++y)
+	{
+		const uint32_t* pRow{ reinterpret_cast<const uint32_t*>(static_cast<const uint8_t*>(pSurface->pixels) + y * pSurface->pitch) };
+		for (int x{ 0 }; x < width; ++x)
+		{
+			Uint8 r{}, g{}, b{};
+			SDL_GetRGB(pRow[x], pSurface->format, &r, &g, &b);
+			texels[x + y * width] = Pack(r, g, b);
+		}
+	}
+	SDL_FreeSurface(pSurface);
+
+	return new MipTexture(width, height, std::move(texels), isNormalMap);
+}
+
+MipTexture::MipTexture(int width, int height, std::vector<uint32_t>&& texels, const bool isNormalMap)
+{
+	//Every level is about a quarter of the previous one, the whole chain fits in 4/3 of the first level
+	m_Texels.reserve(texels.size() * 4 / 3 + 64 * 16);
+
+	AddLevel(width, height, texels);
+	while (width > 1 || height > 1)
+	{
+		texels = Downsample(texels, width, height, isNormalMap);
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+		AddLevel(width, height, texels);
+	}
+}
+
+void MipTexture::AddLevel(const int width, const int height, const std::vector<uint32_t>& texels)
+{
+	//The texels of partial tiles are left at zero and never read
+	m_Texels.resize(m_Layout.AddLevel(width, height));
+
+	const int levelIndex{ m_Layout.GetNrLevels() - 1 };
+	for (int y{ 0 }; y < height; ++y)
+	{
+		for (int x{ 0 }; x < width; ++x)
+		{
+			m_Texels[m_Layout.GetTexelIndex(levelIndex, x, y)] = texels[x + y * width];
+		}
+	}
+}
+
+ColorRGB MipTexture::Sample(const Vector2& uv) const
+{
+	const uint32_t texel{ m_Texels[m_Layout.GetNearestTexel(uv)] };
+	return { GetChannel(texel, 0) / 255.f, GetChannel(texel, 1) / 255.f, GetChannel(texel, 2) / 255.f };
+}
+
+ColorRGB MipTexture::Sample(const Vector2& uv, const TextureGradient& gradient) const
+{
+	float channels[3]{};
+	m_Layout.ForEachTrilinearTexel(uv, gradient, [this, &channels](const size_t index, const float weight)
+		{
+			const uint32_t texel{ m_Texels[index] };
+			for (int channel{ 0 }; channel < 3; ++channel)
+			{
+				channels[channel] += GetChannel(texel, channel) * weight;
+			}
+		});
+
+	return { channels[0] / 255.f, channels[1] / 255.f, channels[2] / 255.f };
+}
+
+const MipLayout& MipTexture::GetLayout() const
+{
+	return m_Layout;
+}
+const std::vector<uint32_t>& MipTexture::GetTexels() const
+{
+	return m_Texels;
+}
+
+size_t MipLayout::AddLevel(const int width, const int height)
+{
+	Level level{};
+	level.width = width;
+	level.height = height;
+	level.nrTilesX = (width + m_TileSize - 1) / m_TileSize;
+	level.offset = m_Size;
+	m_Levels.push_back(level);
+
+	const int nrTilesY{ (height + m_TileSize - 1) / m_TileSize };
+	m_Size += static_cast<size_t>(level.nrTilesX) * nrTilesY * m_TileSize * m_TileSize;
+	return m_Size;
+}
+
+int MipLayout::GetNrLevels() const
+{
+	return static_cast<int>(m_Levels.size());
+}
+int MipLayout::GetWidth(const int levelIndex) const
+{
+	return m_Levels[levelIndex].width;
+}
+int MipLayout::GetHeight(const int levelIndex) const
+{
+	return m_Levels[levelIndex].height;
+}
+size_t MipLayout::GetSize() const
+{
+	return m_Size;
+}
+
+size_t MipLayout::GetTexelIndex(const int levelIndex, const int x, const int y) const
+{
+	const Level& level{ m_Levels[levelIndex] };
+
+	//Coordinates are never negative, unsigned keeps the divisions as shifts
+	const uint32_t unsignedX{ static_cast<uint32_t>(x) };
+	const uint32_t unsignedY{ static_cast<uint32_t>(y) };
+	const size_t tile{ static_cast<size_t>(unsignedY / m_TileSize) * level.nrTilesX + unsignedX / m_TileSize };
+	const uint32_t texelInTile{ g_MortonBits[unsignedX % m_TileSize] | (g_MortonBits[unsignedY % m_TileSize] << 1) };
+
+	return level.offset + tile * m_TileSize * m_TileSize + texelInTile;
+}
+
+size_t MipLayout::GetNearestTexel(const Vector2& uv) const
+{
+	const Level& level{ m_Levels[0] };
+	const int x{ std::clamp(static_cast<int>(uv.x * level.width), 0, level.width - 1) };
+	const int y{ std::clamp(static_cast<int>(uv.y * level.height), 0, level.height - 1) };
+
+	return GetTexelIndex(0, x, y);
+}
+
+float MipLayout::CalculateLevelOfDetail(const TextureGradient& gradient) const
+{
+	//Size of the pixel footprint in texels of the first level
+	const Level& firstLevel{ m_Levels[0] };
+	const float dxU{ gradient.dx.x * firstLevel.width };
+	const float dxV{ gradient.dx.y * firstLevel.height };
+	const float dyU{ gradient.dy.x * firstLevel.width };
+	const float dyV{ gradient.dy.y * firstLevel.height };
+	const float footprintSquared{ std::max(dxU * dxU + dxV * dxV, dyU * dyU + dyV * dyV) };
+
+	return 0.5f * std::log2(footprintSquared);
+}
+
+void MipLayout::GetBilinearTexels(const int levelIndex, const Vector2& uv, size_t indices[4], float weights[4]) const
+{
+	const Level& level{ m_Levels[levelIndex] };
+
+	//Texel centers are at half coordinates, the edges are clamped
+	const float x{ uv.x * level.width - 0.5f };
+	const float y{ uv.y * level.height - 0.5f };
+	const float floorX{ std::floor(x) };
+	const float floorY{ std::floor(y) };
+	const float fractionX{ x - floorX };
+	const float fractionY{ y - floorY };
+
+	const int x0{ std::clamp(static_cast<int>(floorX), 0, level.width - 1) };
+	const int x1{ std::clamp(static_cast<int>(floorX) + 1, 0, level.width - 1) };
+	const int y0{ std::clamp(static_cast<int>(floorY), 0, level.height - 1) };
+	const int y1{ std::clamp(static_cast<int>(floorY) + 1, 0, level.height - 1) };
+
+	indices[0] = GetTexelIndex(levelIndex, x0, y0);
+	indices[1] = GetTexelIndex(levelIndex, x1, y0);
+	indices[2] = GetTexelIndex(levelIndex, x0, y1);
+	indices[3] = GetTexelIndex(levelIndex, x1, y1);
+
+	weights[0] = (1 - fractionX) * (1 - fractionY);
+	weights[1] = fractionX * (1 - fractionY);
+	weights[2] = (1 - fractionX) * fractionY;
+	weights[3] = fractionX * fractionY;
+}
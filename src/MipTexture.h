@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Maths.h"
+
+namespace dae
+{
+	//Change of the uv from one pixel to the next one in x and in y
+	struct TextureGradient
+	{
+		Vector2 dx{};
+		Vector2 dy{};
+	};
+
+	enum struct TextureFilter
+	{
+		Point, //Nearest texel of the full resolution level, like Texture::Sample
+		Trilinear
+	};
+
+	//Position of the texels of a mip chain in memory
+	//Every level is stored in tiles of 8x8 texels with a Morton order inside of the tile,
+	//so the texels used by neighbouring pixels are close in memory whatever the direction of the walk
+	class MipLayout final
+	{
+	public:
+		//Returns the number of texels needed for all the levels added so far
+		size_t AddLevel(int width, int height);
+
+		int GetNrLevels() const;
+		int GetWidth(int levelIndex) const;
+		int GetHeight(int levelIndex) const;
+		size_t GetSize() const;
+
+		size_t GetTexelIndex(int levelIndex, int x, int y) const;
+		size_t GetNearestTexel(const Vector2& uv) const; //In the first level
+		float CalculateLevelOfDetail(const TextureGradient& gradient) const;
+
+		//The 4 texels of the bilinear filter of a level, with their weight
+		void GetBilinearTexels(int levelIndex, const Vector2& uv, size_t indices[4], float weights[4]) const;
+
+		//Calls addTexel(index, weight) for every texel of the trilinear filter
+		template<typename AddTexel>
+		void ForEachTrilinearTexel(const Vector2& uv, const TextureGradient& gradient, AddTexel&& addTexel) const;
+
+	private:
+		struct Level
+		{
+			int width{};
+			int height{};
+			int nrTilesX{};
+			size_t offset{}; //First texel of the level
+		};
+
+		static constexpr int m_TileSize{ 8 };
+
+		std::vector<Level> m_Levels{};
+		size_t m_Size{};
+	};
+
+	template<typename AddTexel>
+	void MipLayout::ForEachTrilinearTexel(const Vector2& uv, const TextureGradient& gradient, AddTexel&& addTexel) const
+	{
+		const float lod{ CalculateLevelOfDetail(gradient) };
+		const int lastLevel{ GetNrLevels() - 1 };
+
+		//Magnification uses the first level, this also catches the nan of an invalid gradient
+		int levelIndex{ 0 };
+		float fraction{ 0 };
+		if (lod >= lastLevel)
+		{
+			levelIndex = lastLevel;
+		}
+		else if (lod > 0)
+		{
+			levelIndex = static_cast<int>(lod);
+			fraction = lod - levelIndex;
+		}
+
+		size_t indices[4]{};
+		float weights[4]{};
+		GetBilinearTexels(levelIndex, uv, indices, weights);
+		for (int i{ 0 }; i < 4; ++i)
+		{
+			addTexel(indices[i], weights[i] * (1 - fraction));
+		}
+
+		if (fraction <= 0) return;
+
+		GetBilinearTexels(levelIndex + 1, uv, indices, weights);
+		for (int i{ 0 }; i < 4; ++i)
+		{
+			addTexel(indices[i], weights[i] * fraction);
+		}
+	}
+
+	//Texture with its mip chain built at load time
+	class MipTexture final
+	{
+	public:
+		~MipTexture() = default;
+
+		MipTexture(const MipTexture&) = delete;
+		MipTexture(MipTexture&&) noexcept = delete;
+		MipTexture& operator=(const MipTexture&) = delete;
+		MipTexture& operator=(MipTexture&&) noexcept = delete;
+
+		//Nullptr when the file can't be loaded
+		//The levels of a normal map are renormalized instead of only averaged
+		static MipTexture* LoadFromFile(const std::string& path, bool isNormalMap = false);
+
+		ColorRGB Sample(const Vector2& uv) const;
+		ColorRGB Sample(const Vector2& uv, const TextureGradient& gradient) const; //Level chosen from the gradient
+
+		const MipLayout& GetLayout() const;
+		const std::vector<uint32_t>& GetTexels() const; //Red, green and blue in the lowest 3 bytes, in the order of the layout
+
+	private:
+		MipTexture(int width, int height, std::vector<uint32_t>&& texels, bool isNormalMap);
+
+		void AddLevel(int width, int height, const std::vector<uint32_t>& texels);
+
+		MipLayout m_Layout{};
+		std::vector<uint32_t> m_Texels{};
+	};
+}
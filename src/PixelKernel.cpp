@@ -0,0 +1,85 @@
+//External includes
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+//Project includes
+#include "PixelKernel.h"
+#include "PixelKernelImpl.h"
+#include "SSELanes.h"
+
+namespace dae
+{
+	namespace
+	{
+		bool CpuSupportsAVX2()
+		{
+#ifdef _MSC_VER
+			int info[4]{};
+			__cpuid(info, 0);
+			if (info[0] < 7) return false;
+
+			//The cpu has to support AVX and the OS has to save the ymm registers
+			__cpuid(info, 1);
+			const bool hasOSXSave{ (info[2] & (1 << 27)) != 0 };
+			const bool hasAVX{ (info[2] & (1 << 28)) != 0 };
+			if (!hasOSXSave || !hasAVX || (_xgetbv(0) & 0x6) != 0x6) return false;
+
+			__cpuidex(info, 7, 0);
+			return (info[1] & (1 << 5)) != 0;
+#else
+			return __builtin_cpu_supports("avx2");
+#endif
+		}
+	}
+
+	bool PixelKernel::IsSupported(const PixelKernelType type)
+	{
+		static const bool supportsAVX2{ CpuSupportsAVX2() };
+
+		switch (type)
+		{
+		case PixelKernelType::AVX2:
+			return supportsAVX2;
+		default:
+			return true;
+		}
+	}
+
+	PixelKernelType PixelKernel::GetBestSupported()
+	{
+		return IsSupported(PixelKernelType::AVX2) ? PixelKernelType::AVX2 : PixelKernelType::SSE;
+	}
+
+	const char* PixelKernel::GetName(const PixelKernelType type)
+	{
+		switch (type)
+		{
+		case PixelKernelType::SSE:
+			return "SSE";
+		case PixelKernelType::AVX2:
+			return "AVX2";
+		default:
+			return "Scalar";
+		}
+	}
+
+	PixelKernel::BlockFunction PixelKernel::GetBlockFunction(const PixelKernelType type)
+	{
+		switch (type)
+		{
+		case PixelKernelType::SSE:
+			return &EvaluateBlockSSE;
+		case PixelKernelType::AVX2:
+			return &EvaluateBlockAVX2;
+		default:
+			return nullptr;
+		}
+	}
+
+	void PixelKernel::EvaluateBlockSSE(const KernelTriangle& triangle, const Vector3& rowWeights, const float firstOffset,
+		const float* pDepth, const int count, const bool interpolateShading, const bool useFastMath, PixelBlock& block)
+	{
+		EvaluateBlock<SSELanes>(triangle, rowWeights, firstOffset, pDepth, count, interpolateShading, useFastMath, block);
+	}
+}
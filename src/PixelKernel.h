@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+
+#include "DataTypes.h"
+
+namespace dae
+{
+	//Instruction set used to rasterize the pixels
+	enum struct PixelKernelType
+	{
+		Scalar,
+		SSE,
+		AVX2
+	};
+
+	//Per triangle constants of the block kernels, gathered once before walking the pixels
+	struct KernelTriangle
+	{
+		Vector3 edgeStepX{};
+		float inverseArea{};
+
+		//Projected z and w of the three vertices
+		float z[3]{};
+		float w[3]{};
+		float inverseW[3]{}; //FastMath::Reciprocal of w, only set for the fast math
+
+		//Vertex attributes, uv already divided by w for the perspective correction, or multiplied by inverseW for the fast math
+		Vector2 uvOverW[3]{};
+		Vector3 normal[3]{};
+		Vector3 tangent[3]{};
+		Vector3 viewDirection[3]{};
+	};
+
+	//Result of the kernel for a row of 8 pixels, stored as structure of arrays
+	struct alignas(32) PixelBlock
+	{
+		static constexpr int size{ 8 };
+
+		float depth[size];
+		float w[size];
+		float u[size];
+		float v[size];
+
+		//Only filled when the shading attributes are requested
+		float normalX[size];
+		float normalY[size];
+		float normalZ[size];
+		float tangentX[size];
+		float tangentY[size];
+		float tangentZ[size];
+		float viewX[size];
+		float viewY[size];
+		float viewZ[size];
+
+		uint32_t depthPassMask{}; //One bit per pixel that passed the depth test
+		uint32_t visibleMask{}; //Pixels that also passed the uv test
+	};
+
+	namespace PixelKernel
+	{
+		//rowWeights: edge values at the start of the row
+		//firstOffset: distance in pixels between the start of the row and the first pixel of the block
+		//pDepth: depth buffer at the first pixel of the block, count: number of pixels of the block to evaluate
+		//The rasterizer already found the pixels inside of the triangle, the first count pixels all are
+		//useFastMath: w and the directions use FastMath like Renderer::RenderAPixel does in that mode, the depth is always divided
+		using BlockFunction = void(*)(const KernelTriangle& triangle, const Vector3& rowWeights, float firstOffset,
+			const float* pDepth, int count, bool interpolateShading, bool useFastMath, PixelBlock& block);
+
+		bool IsSupported(PixelKernelType type);
+		PixelKernelType GetBestSupported();
+		const char* GetName(PixelKernelType type);
+
+		//Nullptr for the scalar kernel, it is the per pixel reference path of the renderer
+		BlockFunction GetBlockFunction(PixelKernelType type);
+
+		void EvaluateBlockSSE(const KernelTriangle& triangle, const Vector3& rowWeights, float firstOffset,
+			const float* pDepth, int count, bool interpolateShading, bool useFastMath, PixelBlock& block);
+		void EvaluateBlockAVX2(const KernelTriangle& triangle, const Vector3& rowWeights, float firstOffset,
+			const float* pDepth, int count, bool interpolateShading, bool useFastMath, PixelBlock& block);
+	}
+}
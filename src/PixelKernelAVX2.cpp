@@ -0,0 +1,19 @@
+//This file is compiled with AVX2 enabled (/arch:AVX2), only call it when PixelKernel::IsSupported says so
+//Only use intrinsics here, inline functions of other headers could end up compiled with AVX2 for the whole program
+
+//Project includes
+#include "PixelKernel.h"
+#include "PixelKernelImpl.h"
+#include "AVX2Lanes.h"
+
+namespace dae
+{
+	void PixelKernel::EvaluateBlockAVX2(const KernelTriangle& triangle, const Vector3& rowWeights, const float firstOffset,
+		const float* pDepth, const int count, const bool interpolateShading, const bool useFastMath, PixelBlock& block)
+	{
+		EvaluateBlock<AVX2Lanes>(triangle, rowWeights, firstOffset, pDepth, count, interpolateShading, useFastMath, block);
+
+		//Avoid the penalty of switching back to the non VEX encoded code of the other files
+		_mm256_zeroupper();
+	}
+}
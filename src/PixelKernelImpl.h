@@ -0,0 +1,168 @@
+#pragma once
+
+//Shared body of the block kernels, included by every instruction set translation unit
+//Lanes wraps the intrinsics of one instruction set, see SSELanes.h and AVX2Lanes.h
+//The operations are done in the same order as Renderer::RenderAPixel so both paths give the same bits
+
+#include <cfloat>
+
+#include "PixelKernel.h"
+
+namespace dae
+{
+	namespace
+	{
+		template<typename Lanes>
+		typename Lanes::Float Interpolate(const typename Lanes::Float b0, const typename Lanes::Float b1, const typename Lanes::Float b2, const float a0, const float a1, const float a2)
+		{
+			return Lanes::Add(Lanes::Add(Lanes::Mul(b0, Lanes::Set1(a0)), Lanes::Mul(b1, Lanes::Set1(a1))), Lanes::Mul(b2, Lanes::Set1(a2)));
+		}
+
+		//Same operations as FastMath::Reciprocal and FastMath::Rsqrt
+		template<typename Lanes>
+		typename Lanes::Float FastReciprocal(const typename Lanes::Float a)
+		{
+			const typename Lanes::Float estimate{ Lanes::ReciprocalEstimate(a) };
+			return Lanes::Mul(estimate, Lanes::Sub(Lanes::Set1(2.0f), Lanes::Mul(a, estimate)));
+		}
+		template<typename Lanes>
+		typename Lanes::Float FastRsqrt(const typename Lanes::Float a)
+		{
+			const typename Lanes::Float estimate{ Lanes::RsqrtEstimate(a) };
+			return Lanes::Mul(estimate, Lanes::Sub(Lanes::Set1(1.5f), Lanes::Mul(Lanes::Mul(Lanes::Mul(Lanes::Set1(0.5f), a), estimate), estimate)));
+		}
+
+		//Interpolate a direction and normalize it
+		template<typename Lanes>
+		void InterpolateDirection(const typename Lanes::Float b0, const typename Lanes::Float b1, const typename Lanes::Float b2, const Vector3* pDirections,
+			const bool useFastMath, float* pOutX, float* pOutY, float* pOutZ)
+		{
+			using Float = typename Lanes::Float;
+
+			const Float x{ Interpolate<Lanes>(b0, b1, b2, pDirections[0].x, pDirections[1].x, pDirections[2].x) };
+			const Float y{ Interpolate<Lanes>(b0, b1, b2, pDirections[0].y, pDirections[1].y, pDirections[2].y) };
+			const Float z{ Interpolate<Lanes>(b0, b1, b2, pDirections[0].z, pDirections[1].z, pDirections[2].z) };
+
+			const Float squaredMagnitude{ Lanes::Add(Lanes::Add(Lanes::Mul(x, x), Lanes::Mul(y, y)), Lanes::Mul(z, z)) };
+
+			//FastMath::Normalized
+			if (useFastMath)
+			{
+				const Float inverseMagnitude{ FastRsqrt<Lanes>(squaredMagnitude) };
+				Lanes::Store(pOutX, Lanes::Mul(x, inverseMagnitude));
+				Lanes::Store(pOutY, Lanes::Mul(y, inverseMagnitude));
+				Lanes::Store(pOutZ, Lanes::Mul(z, inverseMagnitude));
+				return;
+			}
+
+			const Float magnitude{ Lanes::Sqrt(squaredMagnitude) };
+
+			Lanes::Store(pOutX, Lanes::Div(x, magnitude));
+			Lanes::Store(pOutY, Lanes::Div(y, magnitude));
+			Lanes::Store(pOutZ, Lanes::Div(z, magnitude));
+		}
+
+		template<typename Lanes>
+		void EvaluateBlock(const KernelTriangle& triangle, const Vector3& rowWeights, const float firstOffset,
+			const float* pDepth, const int count, const bool interpolateShading, const bool useFastMath, PixelBlock& block)
+		{
+			using Float = typename Lanes::Float;
+
+			//Partial blocks read a padded copy, so we never read depth values of another tile
+			alignas(32) float paddedDepth[PixelBlock::size];
+			if (count < PixelBlock::size)
+			{
+				for (int i{ 0 }; i < PixelBlock::size; ++i)
+				{
+					paddedDepth[i] = i < count ? pDepth[i] : -FLT_MAX;
+				}
+				pDepth = paddedDepth;
+			}
+
+			const Float zero{ Lanes::Set1(0.0f) };
+			const Float one{ Lanes::Set1(1.0f) };
+
+			block.depthPassMask = 0;
+			block.visibleMask = 0;
+
+			//The covered pixels were found by the rasterizer, only the ones past the end of the row are left out
+			const uint32_t countMask{ (1u << count) - 1 };
+			const uint32_t laneMask{ (1u << Lanes::count) - 1 };
+
+			for (int lane{ 0 }; lane < count; lane += Lanes::count)
+			{
+				const Float offset{ Lanes::Add(Lanes::Set1(firstOffset + lane), Lanes::LaneIndex()) };
+				const uint32_t coverageMask{ (countMask >> lane) & laneMask };
+
+				//Edge values
+				const Float w0{ Lanes::Add(Lanes::Set1(rowWeights.x), Lanes::Mul(Lanes::Set1(triangle.edgeStepX.x), offset)) };
+				const Float w1{ Lanes::Add(Lanes::Set1(rowWeights.y), Lanes::Mul(Lanes::Set1(triangle.edgeStepX.y), offset)) };
+				const Float w2{ Lanes::Add(Lanes::Set1(rowWeights.z), Lanes::Mul(Lanes::Set1(triangle.edgeStepX.z), offset)) };
+
+				//Barycentric weights
+				const Float inverseArea{ Lanes::Set1(triangle.inverseArea) };
+				const Float b0{ Lanes::Mul(w0, inverseArea) };
+				const Float b1{ Lanes::Mul(w1, inverseArea) };
+				const Float b2{ Lanes::Mul(w2, inverseArea) };
+
+				//Corrected Depth interpolation
+				const Float zSum
+				{
+					Lanes::Add(Lanes::Add(
+						Lanes::Div(b0, Lanes::Set1(triangle.z[0])),
+						Lanes::Div(b1, Lanes::Set1(triangle.z[1]))),
+						Lanes::Div(b2, Lanes::Set1(triangle.z[2])))
+				};
+				const Float depth{ Lanes::Div(one, zSum) };
+
+				const Float depthRejected
+				{
+					Lanes::Or(Lanes::Or(Lanes::Less(depth, zero), Lanes::Greater(depth, one)),
+						Lanes::GreaterEqual(depth, Lanes::Load(pDepth + lane)))
+				};
+				block.depthPassMask |= (~static_cast<uint32_t>(Lanes::MoveMask(depthRejected)) & coverageMask) << lane;
+
+				//W value, the fast math multiplies by the reciprocals instead of dividing
+				const Float wSum
+				{
+					useFastMath ?
+					Lanes::Add(Lanes::Add(
+						Lanes::Mul(b0, Lanes::Set1(triangle.inverseW[0])),
+						Lanes::Mul(b1, Lanes::Set1(triangle.inverseW[1]))),
+						Lanes::Mul(b2, Lanes::Set1(triangle.inverseW[2]))) :
+					Lanes::Add(Lanes::Add(
+						Lanes::Div(b0, Lanes::Set1(triangle.w[0])),
+						Lanes::Div(b1, Lanes::Set1(triangle.w[1]))),
+						Lanes::Div(b2, Lanes::Set1(triangle.w[2])))
+				};
+				const Float wInterpolated{ useFastMath ? FastReciprocal<Lanes>(wSum) : Lanes::Div(one, wSum) };
+
+				//interpolated UV
+				const Float u{ Lanes::Mul(Interpolate<Lanes>(b0, b1, b2, triangle.uvOverW[0].x, triangle.uvOverW[1].x, triangle.uvOverW[2].x), wInterpolated) };
+				const Float v{ Lanes::Mul(Interpolate<Lanes>(b0, b1, b2, triangle.uvOverW[0].y, triangle.uvOverW[1].y, triangle.uvOverW[2].y), wInterpolated) };
+
+				const Float uvRejected
+				{
+					Lanes::Or(Lanes::Or(Lanes::Less(u, zero), Lanes::Greater(u, one)),
+						Lanes::Or(Lanes::Less(v, zero), Lanes::Greater(v, one)))
+				};
+
+				const uint32_t visibleMask{ ~static_cast<uint32_t>(Lanes::MoveMask(Lanes::Or(depthRejected, uvRejected))) & coverageMask };
+				block.visibleMask |= visibleMask << lane;
+				if (!visibleMask) continue;
+
+				Lanes::Store(block.depth + lane, depth);
+				Lanes::Store(block.w + lane, wInterpolated);
+				Lanes::Store(block.u + lane, u);
+				Lanes::Store(block.v + lane, v);
+
+				if (interpolateShading)
+				{
+					InterpolateDirection<Lanes>(b0, b1, b2, triangle.normal, useFastMath, block.normalX + lane, block.normalY + lane, block.normalZ + lane);
+					InterpolateDirection<Lanes>(b0, b1, b2, triangle.tangent, useFastMath, block.tangentX + lane, block.tangentY + lane, block.tangentZ + lane);
+					InterpolateDirection<Lanes>(b0, b1, b2, triangle.viewDirection, useFastMath, block.viewX + lane, block.viewY + lane, block.viewZ + lane);
+				}
+			}
+		}
+	}
+}
@@ -5,371 +5,2253 @@
 //Project includes
 #include "Renderer.h"
 #include "Maths.h"
-#include "Texture.h"
+#include "Material.h"
 #include "Utils.h"
 #include "Camera.h"
+#include "Scene.h"
+#include "MeshCache.h"
+#include "Clipper.h"
+#include "MeshSimplifier.h"
+
+#include<bit>
+#include<cmath>
+#include<cstring>
+#include<execution>
+#include<iomanip>
+#include<iostream>
+
+using namespace dae;
+
+namespace
+{
+	size_t GetNrTriangles(const MeshData& mesh, const size_t lod)
+	{
+		const size_t nrIndices{ mesh.lods[lod].nrIndices };
+		switch (mesh.primitiveTopology)
+		{
+		case PrimitiveTopology::TriangleStrip:
+			return nrIndices < 3 ? 0 : nrIndices - 2;
+		default:
+			return nrIndices / 3;
+		}
+	}
+
+	//Distance to the closest point of the box, 0 inside of it
+	float GetDistance(const BoundingBox& box, const Vector3& point)
+	{
+		const Vector3 closestPoint
+		{
+			std::clamp(point.x, box.min.x, box.max.x),
+			std::clamp(point.y, box.min.y, box.max.y),
+			std::clamp(point.z, box.min.z, box.max.z)
+		};
+		return (point - closestPoint).Magnitude();
+	}
+
+	//Largest scale of the axes of the matrix, the object space errors grow by it at most
+	float GetMaxScale(const Matrix& matrix)
+	{
+		float maxScale{ 0.0f };
+		for (int axis{ 0 }; axis < 3; ++axis)
+		{
+			maxScale = std::max(maxScale, Vector3{ matrix[axis].x, matrix[axis].y, matrix[axis].z }.Magnitude());
+		}
+		return maxScale;
+	}
+
+	//Interpolated directions are normalized like the block kernels do in the math mode of the shader
+	template<typename Shader>
+	Vector3 NormalizeDirection(const Vector3& direction)
+	{
+		if constexpr (Shader::useFastMath) return FastMath::Normalized(direction);
+		else return direction.Normalized();
+	}
+}
+
+bool ScreenRect::IsEmpty() const
+{
+	return minX >= maxX || minY >= maxY;
+}
+bool ScreenRect::Overlaps(const ScreenRect& other) const
+{
+	return !IsEmpty() && !other.IsEmpty()
+		&& minX < other.maxX && other.minX < maxX && minY < other.maxY && other.minY < maxY;
+}
+void ScreenRect::Add(const ScreenRect& other)
+{
+	if (other.IsEmpty()) return;
+	if (IsEmpty())
+	{
+		*this = other;
+		return;
+	}
+
+	minX = std::min(minX, other.minX);
+	minY = std::min(minY, other.minY);
+	maxX = std::max(maxX, other.maxX);
+	maxY = std::max(maxY, other.maxY);
+}
+
+bool FrameStateKey::operator==(const FrameStateKey& other) const
+{
+	//A camera updated without moving gives the same bits
+	return std::memcmp(&viewMatrix, &other.viewMatrix, sizeof(Matrix)) == 0
+		&& std::memcmp(&projectionMatrix, &other.projectionMatrix, sizeof(Matrix)) == 0
+		&& width == other.width
+		&& height == other.height
+		&& displayZBuffer == other.displayZBuffer
+		&& displayNormalMap == other.displayNormalMap
+		&& shadingMode == other.shadingMode
+		&& pixelKernel == other.pixelKernel
+		&& textureFilter == other.textureFilter
+		&& useVisibilityBuffer == other.useVisibilityBuffer
+		&& isBackFaceCullingEnabled == other.isBackFaceCullingEnabled
+		&& useHierarchicalDepth == other.useHierarchicalDepth
+		&& shadingRate == other.shadingRate
+		&& useLevelOfDetail == other.useLevelOfDetail
+		&& vertexFormat == other.vertexFormat
+		&& mathMode == other.mathMode;
+}
+
+Renderer::Renderer(SDL_Window* pWindow) :
+	m_pWindow(pWindow)
+{
+	//Initialize
+	SDL_GetWindowSize(pWindow, &m_BufferWidth, &m_BufferHeight);
+
+	//Create Buffers
+	m_pFrontBuffer = SDL_GetWindowSurface(pWindow);
+	Initialize(RenderAssets{});
+
+	//Only the window is updated while the next frame is prepared, the headless frames are read right after Render
+	m_UsePipelining = true;
+}
+Renderer::Renderer(const int width, const int height, const RenderAssets& assets) :
+	m_BufferWidth(width),
+	m_BufferHeight(height)
+{
+	//Headless, the frames stay in the back buffer
+	Initialize(assets);
+}
+void Renderer::Initialize(const RenderAssets& assets)
+{
+	//Starts at full resolution, the buffers keep the size of the window when the render scale changes
+	m_Width = m_BufferWidth;
+	m_Height = m_BufferHeight;
+
+	//One back buffer per frame data, a pipelined frame is rasterized in one while the other one is presented
+	for (FrameData& frame : m_Frames)
+	{
+		frame.pBackBuffer = SDL_CreateRGBSurface(0, m_BufferWidth, m_BufferHeight, 32, 0, 0, 0, 0);
+	}
+	m_pBackBuffer = m_pRasterizedFrame->pBackBuffer;
+	m_pBackBufferPixels = (uint32_t*)m_pBackBuffer->pixels;
+	m_pDepthBufferPixels = new float[m_BufferWidth * m_BufferHeight];
+	m_pVisibilityBufferPixels = new uint32_t[m_BufferWidth * m_BufferHeight];
+	m_ClearColor = SDL_MapRGB(m_pBackBuffer->format,
+		static_cast<uint8_t>(m_AmbiantColor.r * 255),
+		static_cast<uint8_t>(m_AmbiantColor.g * 255),
+		static_cast<uint8_t>(m_AmbiantColor.b * 255));
+	InitTiles();
+
+	//Initialize Camera
+	m_Camera.Initialize(45.f, { .0f,5.0f,-64.f });
+	m_Camera.aspectRatio = static_cast<float>(m_BufferWidth) / m_BufferHeight;
+	m_Camera.CalculateViewMatrix();
+	m_Camera.CalculateProjectionMatrix();
+
+	//InitTexture, the maps are packed in one material, only the diffuse map is required
+	m_pMaterial = Material::LoadFromFiles(assets.diffusePath, assets.normalPath, assets.glossPath, assets.specularPath);
+
+	//Init shape
+	MeshData vehicle{};
+	MeshCache::LoadOBJ(assets.meshPath, vehicle);
+
+	m_VehicleMesh = m_Scene.AddMesh(std::move(vehicle));
+	m_VehicleInstance = m_Scene.AddInstance(m_VehicleMesh, Matrix::CreateTranslation(m_MeshPosition));
+
+	//Started last, everything it uses is initialized
+	m_RasterThread = std::thread{ &Renderer::RasterLoop, this };
+}
+Renderer::~Renderer()
+{
+	//Finishes the frame in flight first
+	{
+		std::lock_guard lock{ m_RasterMutex };
+		m_IsStopping = true;
+	}
+	m_RasterRequested.notify_one();
+	m_RasterThread.join();
+
+	delete m_pMaterial;
+
+	delete[] m_pDepthBufferPixels;
+	delete[] m_pVisibilityBufferPixels;
+	for (FrameData& frame : m_Frames)
+	{
+		SDL_FreeSurface(frame.pBackBuffer);
+	}
+}
+
+void Renderer::Update(Timer* pTimer)
+{
+	m_Camera.Update(pTimer);
+
+	UpdateRotation(pTimer);	
+	UpdateRenderScale(pTimer->GetElapsed());
+}
+void Renderer::UpdateRotation(Timer* pTimer)
+{
+	//Update the rotation Angle
+	if (m_IsRotationEnabled)
+	{
+		m_MeshRotationAngle += m_MeshRotationSpeed * pTimer->GetElapsed();
+	}
+}
+
+void Renderer::Render()
+{
+	m_Profiler.BeginFrame();
+	{
+		ScopedStageTimer frameTimer{ m_Profiler, ProfileStage::Frame };
+
+		//@START
+		//Functions
+		//All the functions from the previous weeks were deleted to keep the code cleaner
+		//You can find them on my GitHub page :
+		//https://github.com/AlexandreBeeckmans/Rasterizer
+
+		Render_W4_Part1();
+
+		//@END
+		//Pipelined, this is the last frame, presented while the tiles of this one are rasterized
+		//Nothing to present when the last frame was reused as it is
+		if (m_pFrameToPresent)
+		{
+			AddFrameStatistics(*m_pFrameToPresent);
+
+			//Headless renderers have nothing to present to
+			if (m_pWindow)
+			{
+				ScopedStageTimer presentTimer{ m_Profiler, ProfileStage::Present };
+				Present(*m_pFrameToPresent);
+			}
+			m_pFrameToPresent = nullptr;
+		}
+	}
+	m_Profiler.EndFrame();
+}
+
+void Renderer::Present(const FrameData& frame)
+{
+	if (frame.width == m_BufferWidth && frame.height == m_BufferHeight)
+	{
+		SDL_BlitSurface(frame.pBackBuffer, 0, m_pFrontBuffer, 0);
+	}
+	else
+	{
+		//Nearest neighbour stretch of the rendered part to the whole window, also converts the format when needed
+		SDL_Rect renderedRect{ 0, 0, frame.width, frame.height };
+		SDL_BlitScaled(frame.pBackBuffer, &renderedRect, m_pFrontBuffer, 0);
+	}
+	SDL_UpdateWindowSurface(m_pWindow);
+}
+
+void Renderer::TogglePipelining()
+{
+	SetPipelining(!m_UsePipelining);
+}
+void Renderer::SetPipelining(const bool isEnabled)
+{
+	WaitForFrame();
+	m_UsePipelining = isEnabled;
+}
+bool Renderer::IsPipeliningEnabled() const
+{
+	return m_UsePipelining;
+}
+void Renderer::WaitForFrame()
+{
+	if (!m_HasFrameInFlight) return;
+
+	{
+		std::unique_lock lock{ m_RasterMutex };
+		m_RasterDone.wait(lock, [this]() { return !m_IsRasterizing; });
+	}
+	m_HasFrameInFlight = false;
+	m_pFrameToPresent = m_pRasterizedFrame;
+}
+void Renderer::RasterLoop()
+{
+	while (true)
+	{
+		{
+			std::unique_lock lock{ m_RasterMutex };
+			m_RasterRequested.wait(lock, [this]() { return m_IsStopping || m_IsRasterizing; });
+
+			//Only stop once the requested frame is done
+			if (!m_IsRasterizing) return;
+		}
+
+		RasterizeFrame();
+
+		{
+			std::lock_guard lock{ m_RasterMutex };
+			m_IsRasterizing = false;
+		}
+		m_RasterDone.notify_one();
+	}
+}
+
+void Renderer::SetMeshRotation(const float angle)
+{
+	m_MeshRotationAngle = angle;
+}
+void Renderer::AddVehicleCopies(const int nrCopies)
+{
+	if (nrCopies <= 0) return;
+
+	//A bit more than the size of the vehicle between two of them, so they don't overlap when it rotates
+	const Vector3 size{ m_Scene.GetInstances()[m_VehicleInstance].pMesh->bounds.GetSize() };
+	const float spacing{ 1.5f * std::max(size.x, size.z) };
+
+	//Odd number of columns, the first vehicle stays in the center cell
+	int gridSize{ static_cast<int>(std::ceil(std::sqrt(nrCopies + 1.0f))) };
+	gridSize += 1 - gridSize % 2;
+	const int halfGridSize{ gridSize / 2 };
+
+	int nrAdded{ 0 };
+	for (int z{ -halfGridSize }; z <= halfGridSize && nrAdded < nrCopies; ++z)
+	{
+		for (int x{ -halfGridSize }; x <= halfGridSize && nrAdded < nrCopies; ++x)
+		{
+			if (x == 0 && z == 0) continue;
+
+			const Vector3 position{ m_MeshPosition + Vector3{ x * spacing, 0.0f, z * spacing } };
+			m_Scene.AddInstance(m_VehicleMesh, Matrix::CreateTranslation(position));
+			++nrAdded;
+		}
+	}
+}
+void Renderer::SetCameraOrigin(const Vector3& origin)
+{
+	//Scripted cameras don't go through Camera::Update, so the matrices are calculated here
+	m_Camera.origin = origin;
+	m_Camera.CalculateViewMatrix();
+	m_Camera.CalculateProjectionMatrix();
+}
+const Vector3& Renderer::GetCameraOrigin() const
+{
+	return m_Camera.origin;
+}
+
+const uint32_t* Renderer::GetBackBufferPixels() const
+{
+	return m_pBackBufferPixels;
+}
+const SDL_PixelFormat* Renderer::GetBackBufferFormat() const
+{
+	return m_pBackBuffer->format;
+}
+int Renderer::GetWidth() const
+{
+	return m_BufferWidth;
+}
+int Renderer::GetHeight() const
+{
+	return m_BufferHeight;
+}
+
+void Renderer::SetFrameBudget(const float milliseconds)
+{
+	m_FrameBudgetMs = milliseconds;
+	if (m_FrameBudgetMs <= 0) SetRenderScale(1.0f);
+}
+float Renderer::GetRenderScale() const
+{
+	return m_RenderScale;
+}
+void Renderer::UpdateRenderScale(const float elapsedSeconds)
+{
+	if (m_FrameBudgetMs <= 0) return;
+
+	//The scene is idle, show it at full resolution: the next frame renders it once more, the ones after are skipped again
+	//The time of the skipped frames says nothing about the cost of a frame
+	if (m_WasFrameSkipped)
+	{
+		SetRenderScale(1.0f);
+		m_AverageFrameMs = 0.0f;
+		return;
+	}
+
+	//A single long frame (loading, moving the window) doesn't hold the scale down for long
+	const float frameMs{ std::min(elapsedSeconds * 1000.0f, 4 * m_FrameBudgetMs) };
+	m_AverageFrameMs = m_AverageFrameMs > 0 ? m_AverageFrameMs + (frameMs - m_AverageFrameMs) * m_FrameTimeSmoothing : frameMs;
+	if (++m_NrFramesSinceScaleChange < m_NrSettleFrames) return;
+
+	//Only react when clearly over or under the budget, so the resolution doesn't keep changing
+	const float budgetRatio{ m_FrameBudgetMs / m_AverageFrameMs };
+	if (budgetRatio > 0.9f && budgetRatio < 1.2f) return;
+
+	//Most of the cost is per pixel, so it follows the square of the scale
+	const float targetScale{ std::clamp(m_RenderScale * std::sqrt(budgetRatio), m_MinRenderScale, 1.0f) };
+	const float newScale{ std::round(targetScale / m_RenderScaleStep) * m_RenderScaleStep };
+	if (newScale != m_RenderScale) SetRenderScale(newScale);
+}
+void Renderer::SetRenderScale(const float scale)
+{
+	m_NrFramesSinceScaleChange = 0;
+	if (scale == m_RenderScale) return;
+
+	//The tiles are changed, a frame still in flight is presented with its own resolution
+	WaitForFrame();
+
+	m_RenderScale = scale;
+	m_Width = std::max(static_cast<int>(std::round(m_BufferWidth * scale)), 1);
+	m_Height = std::max(static_cast<int>(std::round(m_BufferHeight * scale)), 1);
+
+	//The frame state key has the resolution, the next frame is rendered completely
+	InitTiles();
+}
+
+//Vertex transformation
+void Renderer::VertexTransformationFunction(const std::vector<MeshInstance>& instances)
+{
+	//Calculate this matrix before the for loop to reduce the amount of operation inside of this loop
+	const Matrix viewProjectionMatrix{ m_Camera.viewMatrix * m_Camera.projectionMatrix };
+
+	//Split every instance in chunks, so a single big mesh still uses all the workers
+	//The vectors keep their memory and the chunks are in the arena of the frame, after the first frame this doesn't allocate
+	FrameData& frame{ *m_pPreparedFrame };
+	std::vector<InstanceVertices>& instanceVertices{ frame.instanceVertices };
+	instanceVertices.resize(instances.size());
+	m_TransformConstants.resize(instances.size());
+
+	//The output is still valid when the instance didn't move since this frame data was used
+	//Pipelined, that can be two frames ago
+	//The culled instances keep their old output, it is transformed again once they are visible
+	size_t nrChunks{ 0 };
+	for (size_t instanceIndex{ 0 }; instanceIndex < instances.size(); ++instanceIndex)
+	{
+		if (!m_IsInstanceVisible[instanceIndex]) continue;
+		const InstanceVertices& vertices{ instanceVertices[instanceIndex] };
+		const size_t nrVertices{ instances[instanceIndex].pMesh->lods[m_InstanceLods[instanceIndex]].nrVertices };
+		if (vertices.version == m_InstanceStates[instanceIndex].version && vertices.nrVertices >= nrVertices) continue;
+		nrChunks += (nrVertices + m_VertexChunkSize - 1) / m_VertexChunkSize;
+	}
+
+	const std::span<VertexChunk> chunks{ frame.arena.GetMainArena().Allocate<VertexChunk>(nrChunks) };
+	size_t chunkIndex{ 0 };
+	for (size_t instanceIndex{ 0 }; instanceIndex < instances.size(); ++instanceIndex)
+	{
+		if (!m_IsInstanceVisible[instanceIndex]) continue;
+		InstanceVertices& vertices{ instanceVertices[instanceIndex] };
+		const MeshInstance& instance{ instances[instanceIndex] };
+		const uint32_t version{ m_InstanceStates[instanceIndex].version };
+		const size_t nrVertices{ instance.pMesh->lods[m_InstanceLods[instanceIndex]].nrVertices };
+		if (vertices.version == version && vertices.nrVertices >= nrVertices) continue;
+		vertices.version = version;
+		vertices.nrVertices = nrVertices;
+
+		if (vertices.streams.size != instance.pMesh->vertices.size()) vertices.streams.Resize(instance.pMesh->vertices.size());
+
+		VertexKernel::TransformConstants& constants{ m_TransformConstants[instanceIndex] };
+		constants.Set(instance.worldMatrix, viewProjectionMatrix, m_Camera.origin, m_Width, m_Height);
+
+		//Only the vertices of the level of detail, the streams are padded so the last chunk can go past the last of them
+		const size_t paddedSize{ (nrVertices + VertexKernel::padding - 1) / VertexKernel::padding * VertexKernel::padding };
+		for (size_t first{ 0 }; first < paddedSize; first += m_VertexChunkSize)
+		{
+			chunks[chunkIndex++] = { &instance, &vertices.streams, &constants, first, std::min(m_VertexChunkSize, paddedSize - first) };
+		}
+	}
+
+	//Every chunk writes its own part of the output streams of its instance
+	const VertexKernel::TransformFunction transform{ VertexKernel::GetTransformFunction(m_PixelKernel) };
+	const VertexKernel::TransformQuantizedFunction transformQuantized{ VertexKernel::GetTransformQuantizedFunction(m_PixelKernel) };
+	const bool isQuantized{ m_Scene.GetVertexFormat() == VertexFormat::Quantized };
+	std::for_each(std::execution::par, chunks.begin(), chunks.end(), [transform, transformQuantized, isQuantized](const VertexChunk& chunk)
+		{
+			const MeshData& mesh{ *chunk.pInstance->pMesh };
+			if (isQuantized) transformQuantized(*chunk.pConstants, mesh.quantizedStreams, *chunk.pOutput, chunk.first, chunk.count);
+			else transform(*chunk.pConstants, mesh.streams, *chunk.pOutput, chunk.first, chunk.count);
+		});
+}
+
+void Renderer::ToggleBackFaceCulling()
+{
+	m_IsBackFaceCullingEnabled = !m_IsBackFaceCullingEnabled;
+}
+bool Renderer::IsBackFaceCullingEnabled() const
+{
+	return m_IsBackFaceCullingEnabled;
+}
+void Renderer::ToggleHierarchicalDepth()
+{
+	WaitForFrame();
+	m_UseHierarchicalDepth = !m_UseHierarchicalDepth;
+}
+bool Renderer::IsHierarchicalDepthEnabled() const
+{
+	return m_UseHierarchicalDepth;
+}
+void Renderer::ToggleDisplayZBuffer()
+{
+	//Invert displaying of ZBuffer
+	m_DisplayZBuffer = !m_DisplayZBuffer;
+}
+void Renderer::ToggleRotation()
+{
+	//Enable / Disable Rotation
+	m_IsRotationEnabled = !m_IsRotationEnabled;
+}
+void Renderer::ToggleNormalMap()
+{
+	//Display / Hide normal map
+	m_DisplayNormalMap = !m_DisplayNormalMap;
+}
+void Renderer::CycleShadingMode()
+{
+	//Change Shading mode
+
+	switch (m_ShadingMode)
+	{
+	case ShadingMode::ObservedArea:
+		m_ShadingMode = ShadingMode::Diffuse;
+		break;
+	case ShadingMode::Diffuse:
+		m_ShadingMode = ShadingMode::Specular;
+		break;
+	case ShadingMode::Specular:
+		m_ShadingMode = ShadingMode::Combined;
+		break;
+	case ShadingMode::Combined:
+		m_ShadingMode = ShadingMode::ObservedArea;
+		break;
+	}
+}
+void Renderer::SetShadingMode(const ShadingMode shadingMode)
+{
+	m_ShadingMode = shadingMode;
+}
+void Renderer::SetDisplayNormalMap(const bool isDisplayed)
+{
+	m_DisplayNormalMap = isDisplayed;
+}
+void Renderer::CyclePixelKernel()
+{
+	WaitForFrame();
+
+	//Go to the next kernel supported by the cpu
+	do
+	{
+		switch (m_PixelKernel)
+		{
+		case PixelKernelType::Scalar:
+			m_PixelKernel = PixelKernelType::SSE;
+			break;
+		case PixelKernelType::SSE:
+			m_PixelKernel = PixelKernelType::AVX2;
+			break;
+		case PixelKernelType::AVX2:
+			m_PixelKernel = PixelKernelType::Scalar;
+			break;
+		}
+	} while (!PixelKernel::IsSupported(m_PixelKernel));
+}
+PixelKernelType Renderer::GetPixelKernel() const
+{
+	return m_PixelKernel;
+}
+void Renderer::ToggleVisibilityBuffer()
+{
+	WaitForFrame();
+	m_UseVisibilityBuffer = !m_UseVisibilityBuffer;
+}
+bool Renderer::IsVisibilityBufferEnabled() const
+{
+	return m_UseVisibilityBuffer;
+}
+void Renderer::ToggleTextureFilter()
+{
+	WaitForFrame();
+	m_TextureFilter = m_TextureFilter == TextureFilter::Trilinear ? TextureFilter::Point : TextureFilter::Trilinear;
+}
+TextureFilter Renderer::GetTextureFilter() const
+{
+	return m_TextureFilter;
+}
+void Renderer::CycleShadingRate()
+{
+	WaitForFrame();
+	switch (m_ShadingRate)
+	{
+	case ShadingRate::Full:
+		m_ShadingRate = ShadingRate::Coarse2x2;
+		break;
+	case ShadingRate::Coarse2x2:
+		m_ShadingRate = ShadingRate::Coarse4x4;
+		break;
+	case ShadingRate::Coarse4x4:
+		m_ShadingRate = ShadingRate::Adaptive;
+		break;
+	case ShadingRate::Adaptive:
+		m_ShadingRate = ShadingRate::Full;
+		break;
+	}
+}
+void Renderer::SetShadingRate(const ShadingRate shadingRate)
+{
+	WaitForFrame();
+	m_ShadingRate = shadingRate;
+}
+ShadingRate Renderer::GetShadingRate() const
+{
+	return m_ShadingRate;
+}
+const char* Renderer::GetShadingRateName(const ShadingRate shadingRate)
+{
+	switch (shadingRate)
+	{
+	case ShadingRate::Coarse2x2:
+		return "2x2";
+	case ShadingRate::Coarse4x4:
+		return "4x4";
+	case ShadingRate::Adaptive:
+		return "Adaptive";
+	default:
+		return "Full";
+	}
+}
+void Renderer::ToggleFrameReuse()
+{
+	SetFrameReuse(!m_UseFrameReuse);
+}
+void Renderer::SetFrameReuse(const bool isEnabled)
+{
+	m_UseFrameReuse = isEnabled;
+}
+bool Renderer::IsFrameReuseEnabled() const
+{
+	return m_UseFrameReuse;
+}
+void Renderer::ToggleLevelOfDetail()
+{
+	SetLevelOfDetail(!m_UseLevelOfDetail);
+}
+void Renderer::SetLevelOfDetail(const bool isEnabled)
+{
+	m_UseLevelOfDetail = isEnabled;
+}
+bool Renderer::IsLevelOfDetailEnabled() const
+{
+	return m_UseLevelOfDetail;
+}
+void Renderer::ToggleVertexFormat()
+{
+	SetVertexFormat(GetVertexFormat() == VertexFormat::Float ? VertexFormat::Quantized : VertexFormat::Float);
+}
+void Renderer::SetVertexFormat(const VertexFormat vertexFormat)
+{
+	//Only the vertex stage reads the streams, it runs on this thread
+	m_Scene.SetVertexFormat(vertexFormat);
+}
+VertexFormat Renderer::GetVertexFormat() const
+{
+	return m_Scene.GetVertexFormat();
+}
+const char* Renderer::GetVertexFormatName(const VertexFormat vertexFormat)
+{
+	return vertexFormat == VertexFormat::Quantized ? "Quantized" : "Float";
+}
+void Renderer::ToggleMathMode()
+{
+	SetMathMode(m_MathMode == MathMode::Precise ? MathMode::Fast : MathMode::Precise);
+}
+void Renderer::SetMathMode(const MathMode mathMode)
+{
+	m_MathMode = mathMode;
+}
+MathMode Renderer::GetMathMode() const
+{
+	return m_MathMode;
+}
+const char* Renderer::GetMathModeName(const MathMode mathMode)
+{
+	return mathMode == MathMode::Fast ? "Fast" : "Precise";
+}
+void Renderer::PrintLevelsOfDetail(std::ostream& stream) const
+{
+	//Without scale, a scaled instance switches at its scale times these distances
+	const float pixelsPerUnit{ GetLodPixelsPerUnit() };
+	stream << "Levels of detail at " << m_Width << "x" << m_Height << ", at most " << m_MaxLodPixelError << " pixel of error"
+		<< (m_UseLevelOfDetail ? "" : " (disabled)") << std::endl;
+	for (size_t meshId{ 0 }; meshId < m_Scene.GetNrMeshes(); ++meshId)
+	{
+		const MeshData& mesh{ m_Scene.GetMesh(meshId) };
+		for (size_t lod{ 0 }; lod < mesh.lods.size(); ++lod)
+		{
+			const float switchDistance{ mesh.lods[lod].error * pixelsPerUnit / m_MaxLodPixelError };
+			stream << "  Mesh " << meshId << " LOD " << lod << ": " << GetNrTriangles(mesh, lod) << " triangles, "
+				<< mesh.lods[lod].nrVertices << " vertices, error " << mesh.lods[lod].error << ", from " << switchDistance << " units away" << std::endl;
+		}
+	}
+}
+bool Renderer::WasFrameSkipped() const
+{
+	return m_WasFrameSkipped;
+}
+void Renderer::ToggleProfiler()
+{
+	//Start from an empty history every time it is enabled
+	WaitForFrame();
+	m_Profiler.SetEnabled(!m_Profiler.IsEnabled());
+	m_Profiler.Reset();
+}
+
+FrameProfiler& Renderer::GetProfiler()
+{
+	return m_Profiler;
+}
+
+bool Renderer::ValidatePixelKernels()
+{
+	const PixelKernelType selectedKernel{ m_PixelKernel };
+	const ShadingRate selectedRate{ m_ShadingRate };
+	const bool usedPipelining{ m_UsePipelining };
+	const bool usedVisibilityBuffer{ m_UseVisibilityBuffer };
+	const int nrPixels{ m_BufferWidth * m_BufferHeight };
+
+	//Every frame is done when Render_W4_Part1 returns
+	WaitForFrame();
+	m_UsePipelining = false;
+
+	//The adaptive rate depends on the last frame, which is the image of the previous kernel here
+	m_ShadingRate = ShadingRate::Full;
+
+	//Both paths call the kernels, the forward one while rasterizing and the visibility buffer one while resolving
+	bool isValid{ true };
+	for (const bool useVisibilityBuffer : { false, true })
+	{
+		m_UseVisibilityBuffer = useVisibilityBuffer;
+		const char* pathName{ useVisibilityBuffer ? "visibility buffer" : "forward" };
+
+		//The scalar kernel gives the reference image
+		m_PixelKernel = PixelKernelType::Scalar;
+		Render_W4_Part1();
+		const std::vector<uint32_t> referenceColors(m_pBackBufferPixels, m_pBackBufferPixels + nrPixels);
+		const std::vector<float> referenceDepths(m_pDepthBufferPixels, m_pDepthBufferPixels + nrPixels);
+
+		for (const PixelKernelType kernel : { PixelKernelType::SSE, PixelKernelType::AVX2 })
+		{
+			if (!PixelKernel::IsSupported(kernel)) continue;
+
+			m_PixelKernel = kernel;
+			Render_W4_Part1();
+
+			//Compare the bits, not the values
+			int nrDifferentPixels{ 0 };
+			for (int pixelNr{ 0 }; pixelNr < nrPixels; ++pixelNr)
+			{
+				if (m_pBackBufferPixels[pixelNr] != referenceColors[pixelNr]
+					|| std::memcmp(&m_pDepthBufferPixels[pixelNr], &referenceDepths[pixelNr], sizeof(float)) != 0)
+				{
+					++nrDifferentPixels;
+				}
+			}
+
+			std::cout << PixelKernel::GetName(kernel) << " kernel, " << pathName << ": " << nrDifferentPixels << " pixels differ from the scalar kernel" << std::endl;
+			isValid = isValid && nrDifferentPixels == 0;
+		}
+	}
+
+	m_PixelKernel = selectedKernel;
+	m_ShadingRate = selectedRate;
+	m_UsePipelining = usedPipelining;
+	m_UseVisibilityBuffer = usedVisibilityBuffer;
+	return isValid;
+}
+
+void Renderer::CompareShadingRates(std::ostream& stream)
+{
+	const ShadingRate selectedRate{ m_ShadingRate };
+	const bool usedFrameReuse{ m_UseFrameReuse };
+	const bool usedPipelining{ m_UsePipelining };
+	const int nrPixels{ m_BufferWidth * m_BufferHeight };
+
+	//Every rate renders the whole frame before Render_W4_Part1 returns, so the times can be compared
+	WaitForFrame();
+	m_UseFrameReuse = false;
+	m_UsePipelining = false;
+
+	const auto render = [this](FrameCounters& counters)
+		{
+			const FrameProfiler::Clock::time_point start{ FrameProfiler::Clock::now() };
+			Render_W4_Part1();
+			const double elapsedMs{ FrameProfiler::ToMilliseconds(FrameProfiler::Clock::now() - start) };
+
+			counters = FrameCounters{};
+			for (const Tile& tile : m_pRasterizedFrame->tiles)
+			{
+				counters += tile.statistics.counters;
+			}
+			return elapsedMs;
+		};
+
+	//The full rate gives the reference image
+	m_ShadingRate = ShadingRate::Full;
+	FrameCounters referenceCounters{};
+	const double referenceMs{ render(referenceCounters) };
+	const std::vector<uint32_t> referenceColors(m_pBackBufferPixels, m_pBackBufferPixels + nrPixels);
+
+	stream << std::fixed << std::setprecision(2);
+	stream << "Full rate: " << referenceCounters.pixelsShaded << " pixels shaded, " << referenceMs << " ms" << std::endl;
+	for (const ShadingRate rate : { ShadingRate::Coarse2x2, ShadingRate::Coarse4x4, ShadingRate::Adaptive })
+	{
+		//The adaptive rate picks its blocks from the full rate image, like after a still frame
+		std::copy(referenceColors.begin(), referenceColors.end(), m_pBackBufferPixels);
+		m_ShadingRate = rate;
+		FrameCounters counters{};
+		const double elapsedMs{ render(counters) };
+
+		int nrDifferentPixels{ 0 };
+		int maxError{ 0 };
+		double sumSquaredError{ 0.0 };
+		for (int pixelNr{ 0 }; pixelNr < nrPixels; ++pixelNr)
+		{
+			if (m_pBackBufferPixels[pixelNr] == referenceColors[pixelNr]) continue;
+			++nrDifferentPixels;
+
+			uint8_t reference[3]{};
+			uint8_t color[3]{};
+			SDL_GetRGB(referenceColors[pixelNr], m_pBackBuffer->format, &reference[0], &reference[1], &reference[2]);
+			SDL_GetRGB(m_pBackBufferPixels[pixelNr], m_pBackBuffer->format, &color[0], &color[1], &color[2]);
+			for (int channel{ 0 }; channel < 3; ++channel)
+			{
+				const int error{ std::abs(color[channel] - reference[channel]) };
+				maxError = std::max(maxError, error);
+				sumSquaredError += error * error;
+			}
+		}
+
+		//Peak signal to noise ratio over the three channels, higher is closer
+		const double meanSquaredError{ sumSquaredError / (3.0 * nrPixels) };
+		stream << GetShadingRateName(rate) << " rate: " << counters.pixelsShaded << " pixels shaded, " << elapsedMs << " ms, "
+			<< 100.0 * nrDifferentPixels / nrPixels << "% pixels differ, max error " << maxError << ", PSNR ";
+		if (meanSquaredError > 0.0) stream << 10.0 * std::log10(255.0 * 255.0 / meanSquaredError) << " dB" << std::endl;
+		else stream << "infinite" << std::endl;
+	}
+	stream << std::defaultfloat;
+
+	m_ShadingRate = selectedRate;
+	m_UseFrameReuse = usedFrameReuse;
+	m_UsePipelining = usedPipelining;
+}
+
+void Renderer::CompareVertexFormats(std::ostream& stream)
+{
+	const VertexFormat selectedFormat{ GetVertexFormat() };
+	const bool usedFrameReuse{ m_UseFrameReuse };
+	const bool usedPipelining{ m_UsePipelining };
+	const int nrPixels{ m_BufferWidth * m_BufferHeight };
+
+	WaitForFrame();
+	m_UseFrameReuse = false;
+	m_UsePipelining = false;
+
+	//The float format gives the reference image and the transform constants of the visible instances
+	SetVertexFormat(VertexFormat::Float);
+	const size_t nrFloatBytes{ m_Scene.GetNrStreamBytes() };
+	Render_W4_Part1();
+	const std::vector<uint32_t> referenceColors(m_pBackBufferPixels, m_pBackBufferPixels + nrPixels);
+
+	//The scene only keeps the float streams now, the quantized ones are built on the side to compare both
+	//Measured by QuantizedVertexStreams::Assign, rounding keeps the positions and uvs within half a step, up to the float rounding of the decoding
+	float maxScreenError{ 0.0f };
+	float maxDepthError{ 0.0f };
+	VertexOutputStreams floatOutput{};
+	VertexOutputStreams quantizedOutput{};
+	const VertexKernel::TransformFunction transform{ VertexKernel::GetTransformFunction(m_PixelKernel) };
+	const VertexKernel::TransformQuantizedFunction transformQuantized{ VertexKernel::GetTransformQuantizedFunction(m_PixelKernel) };
+	const std::vector<MeshInstance>& instances{ m_Scene.GetInstances() };
+	stream << std::setprecision(3);
+	for (size_t meshId{ 0 }; meshId < m_Scene.GetNrMeshes(); ++meshId)
+	{
+		const MeshData& mesh{ m_Scene.GetMesh(meshId) };
+		QuantizedVertexStreams quantized{};
+		quantized.Assign(mesh.vertices);
+		const Vector3 positionStep{ quantized.positionScale[0], quantized.positionScale[1], quantized.positionScale[2] };
+		const float uvStep{ std::max(quantized.uvScale[0], quantized.uvScale[1]) };
+
+		stream << "Mesh " << meshId << ": " << mesh.streams.GetNrBytes() << " bytes as float, " << quantized.GetNrBytes() << " bytes quantized ("
+			<< static_cast<int>(100.0 * quantized.GetNrBytes() / std::max<size_t>(mesh.streams.GetNrBytes(), 1)) << "%), "
+			<< mesh.vertices.size_bytes() << " bytes of vertices they are built from" << std::endl;
+		stream << "  Position error " << quantized.maxPositionError << " (half step " << 0.5f * positionStep.Magnitude() << "), uv error "
+			<< quantized.maxUVError << " (half step " << 0.5f * uvStep << "), normal " << quantized.maxNormalAngle << " degrees, tangent "
+			<< quantized.maxTangentAngle << " degrees" << std::endl;
+
+		//Both formats of the vertices in front of the near plane, the ones outside the screen still shape the clipped triangles
+		for (size_t instanceIndex{ 0 }; instanceIndex < instances.size(); ++instanceIndex)
+		{
+			if (!m_IsInstanceVisible[instanceIndex] || instances[instanceIndex].pMesh != &mesh) continue;
+			floatOutput.Resize(mesh.streams.size);
+			quantizedOutput.Resize(mesh.streams.size);
+			transform(m_TransformConstants[instanceIndex], mesh.streams, floatOutput, 0, mesh.streams.paddedSize);
+			transformQuantized(m_TransformConstants[instanceIndex], quantized, quantizedOutput, 0, mesh.streams.paddedSize);
+
+			for (size_t i{ 0 }; i < mesh.streams.size; ++i)
+			{
+				if ((floatOutput.pOutsidePlanes[i] | quantizedOutput.pOutsidePlanes[i]) & Clipper::outsideNear) continue;
+				const Vector2 screenError{ quantizedOutput.pScreenX[i] - floatOutput.pScreenX[i], quantizedOutput.pScreenY[i] - floatOutput.pScreenY[i] };
+				maxScreenError = std::max(maxScreenError, screenError.Magnitude());
+				maxDepthError = std::max(maxDepthError, std::fabs(quantizedOutput.pDepth[i] - floatOutput.pDepth[i]));
+			}
+		}
+	}
+
+	//Drops the float streams, like switching the format does
+	SetVertexFormat(VertexFormat::Quantized);
+	const size_t nrQuantizedBytes{ m_Scene.GetNrStreamBytes() };
+	Render_W4_Part1();
+
+	int nrDifferentPixels{ 0 };
+	int maxError{ 0 };
+	for (int pixelNr{ 0 }; pixelNr < nrPixels; ++pixelNr)
+	{
+		if (m_pBackBufferPixels[pixelNr] == referenceColors[pixelNr]) continue;
+		++nrDifferentPixels;
+
+		uint8_t reference[3]{};
+		uint8_t color[3]{};
+		SDL_GetRGB(referenceColors[pixelNr], m_pBackBuffer->format, &reference[0], &reference[1], &reference[2]);
+		SDL_GetRGB(m_pBackBufferPixels[pixelNr], m_pBackBuffer->format, &color[0], &color[1], &color[2]);
+		for (int channel{ 0 }; channel < 3; ++channel)
+		{
+			maxError = std::max(maxError, std::abs(color[channel] - reference[channel]));
+		}
+	}
+
+	stream << "Scene streams: " << nrFloatBytes << " bytes with the float format, " << nrQuantizedBytes << " bytes with the quantized format ("
+		<< static_cast<int>(100.0 * nrQuantizedBytes / std::max<size_t>(nrFloatBytes, 1)) << "%)" << std::endl;
+	stream << "Current frame: screen position error " << maxScreenError << " pixels, depth error " << maxDepthError << ", "
+		<< std::fixed << std::setprecision(2) << 100.0 * nrDifferentPixels / nrPixels << "% pixels differ, max error " << maxError << std::endl;
+	stream << std::defaultfloat;
+
+	SetVertexFormat(selectedFormat);
+	m_UseFrameReuse = usedFrameReuse;
+	m_UsePipelining = usedPipelining;
+}
+
+bool Renderer::SaveBufferToImage() const
+{
+	//The window has the picture that was shown, a scaled frame only fills a part of the back buffer
+	//and a pipelined one can still be rasterized
+	return SDL_SaveBMP(m_pFrontBuffer ? m_pFrontBuffer : m_pBackBuffer, "Rasterizer_ColorBuffer.bmp");
+}
+bool Renderer::SetupTriangle(ScreenTriangle& triangle) const
+{
+	//Snap the vertices to the subpixel grid, everything after this is exact integer math
+	//so the covered pixels don't depend on how the compiler rounds floats
+	const auto snap = [](const float value) { return static_cast<int64_t>(std::llround(value * m_SubpixelSteps)); };
+	const int64_t x[3]{ snap(triangle.v0.x), snap(triangle.v1.x), snap(triangle.v2.x) };
+	const int64_t y[3]{ snap(triangle.v0.y), snap(triangle.v1.y), snap(triangle.v2.y) };
+
+	//calculate triangle areas
+	int64_t triangleArea{ (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]) };
+	if (triangleArea == 0) return false;
+
+	//Both windings reach this point when back-face culling is off, flip the edges of clockwise triangles so the inside is always positive
+	const int64_t orientation{ triangleArea > 0 ? 1 : -1 };
+	triangleArea *= orientation;
+	triangle.inverseArea = 1 / static_cast<float>(triangleArea);
+
+	const int64_t firstPixelX{ triangle.minX * m_SubpixelSteps + m_SubpixelSteps / 2 };
+	const int64_t firstPixelY{ triangle.minY * m_SubpixelSteps + m_SubpixelSteps / 2 };
+
+	//Edge i is the one opposite to vertex i, so its value is the weight of vertex i
+	for (int edge{ 0 }; edge < 3; ++edge)
+	{
+		const int start{ (edge + 1) % 3 };
+		const int end{ (edge + 2) % 3 };
+		const int64_t sideX{ x[end] - x[start] };
+		const int64_t sideY{ y[end] - y[start] };
+
+		triangle.edgeStepX[edge] = -sideY * orientation * m_SubpixelSteps;
+		triangle.edgeStepY[edge] = sideX * orientation * m_SubpixelSteps;
+		triangle.edgeOrigin[edge] = (sideX * (firstPixelY - y[start]) - sideY * (firstPixelX - x[start])) * orientation;
+
+		//Top-left rule: a pixel center right on an edge is only inside when the edge is a left edge,
+		//with the inside to its right, or a horizontal top edge, with the inside below it
+		const bool isTopLeft{ triangle.edgeStepX[edge] > 0 || (triangle.edgeStepX[edge] == 0 && triangle.edgeStepY[edge] > 0) };
+		triangle.edgeBias[edge] = isTopLeft ? 0 : 1;
+
+		triangle.edgeStepXFloat[edge] = static_cast<float>(triangle.edgeStepX[edge]);
+		triangle.edgeStepYFloat[edge] = static_cast<float>(triangle.edgeStepY[edge]);
+	}
+
+	return true;
+}
+void Renderer::GetEdgeValues(const ScreenTriangle& triangle, const int px, const int py, int64_t edgeValues[3]) const
+{
+	for (int edge{ 0 }; edge < 3; ++edge)
+	{
+		edgeValues[edge] = triangle.edgeOrigin[edge] + triangle.edgeStepX[edge] * (px - triangle.minX) + triangle.edgeStepY[edge] * (py - triangle.minY);
+	}
+}
+Vector3 Renderer::GetEdgeWeights(const ScreenTriangle& triangle, const int px, const int py) const
+{
+	int64_t edgeValues[3]{};
+	GetEdgeValues(triangle, px, py, edgeValues);
+	return { static_cast<float>(edgeValues[0]), static_cast<float>(edgeValues[1]), static_cast<float>(edgeValues[2]) };
+}
+bool Renderer::GetCoveredSpan(const ScreenTriangle& triangle, const int py, const int minX, const int maxX, int& begin, int& end) const
+{
+	int64_t edgeValues[3]{};
+	GetEdgeValues(triangle, minX, py, edgeValues);
+
+	//Every edge is linear along the row, so the pixels inside of it are a half line, found with one division at most
+	int64_t first{ 0 };
+	int64_t last{ maxX - minX };
+	for (int edge{ 0 }; edge < 3; ++edge)
+	{
+		const int64_t value{ edgeValues[edge] - triangle.edgeBias[edge] }; //Inside when >= 0
+		const int64_t step{ triangle.edgeStepX[edge] };
+		if (step > 0)
+		{
+			if (value < 0) first = std::max(first, (-value + step - 1) / step);
+		}
+		else if (step < 0)
+		{
+			if (value < 0) return false;
+			if (value + step * (last - 1) < 0) last = std::min(last, value / -step + 1);
+		}
+		else if (value < 0)
+		{
+			return false;
+		}
+	}
+
+	if (first >= last) return false;
+	begin = minX + static_cast<int>(first);
+	end = minX + static_cast<int>(last);
+	return true;
+}
+
+template<typename Shader>
+void Renderer::RenderAPixel(const int px, const int py, const ScreenTriangle& triangle, const Vector3& barycentrics, TileStatistics& statistics)
+{
+	const int pixelNr{ px + (m_BufferWidth * py) };
+
+	const Vector4& v0{ triangle.v0 };
+	const Vector4& v1{ triangle.v1 };
+	const Vector4& v2{ triangle.v2 };
+
+	//Corrected Depth interpolation
+	const float z0{ barycentrics.x / v0.z };
+	const float z1{ barycentrics.y / v1.z };
+	const float z2{ barycentrics.z / v2.z };
+
+	float zBufferValue{ 1 / (z0 + z1 + z2) };
+
+	//Check if we can use this buffer value
+	++statistics.counters.pixelsTested;
+	if (zBufferValue < 0 || zBufferValue > 1 || zBufferValue >= m_pDepthBufferPixels[pixelNr]) return;
+	++statistics.counters.pixelsDepthPassed;
+
+	float wInterpolated{};
+	Vector2 interpolatedUV{};
+	InterpolatePerspective<Shader>(triangle, barycentrics, wInterpolated, interpolatedUV);
+
+	//If uv value outside of the uv map, we display nothing
+	if (interpolatedUV.x < 0 || interpolatedUV.x > 1 || interpolatedUV.y < 0 || interpolatedUV.y > 1) return;
+
+	//takes really long
+	m_pDepthBufferPixels[pixelNr] = zBufferValue;
+
+	//The visibility pass only remembers the triangle, the pixel is shaded once the whole tile is known
+	if constexpr (Shader::visibilityOnly)
+	{
+		m_pVisibilityBufferPixels[pixelNr] = static_cast<uint32_t>(&triangle - m_pRasterizedFrame->triangles.data());
+	}
+	else
+	{
+		ShadeFragment<Shader>(px, py, triangle, barycentrics, zBufferValue, wInterpolated, interpolatedUV, statistics);
+	}
+}
+template<typename Shader>
+void Renderer::InterpolatePerspective(const ScreenTriangle& triangle, const Vector3& barycentrics, float& wInterpolated, Vector2& uv) const
+{
+	const Vector4& v0{ triangle.v0 };
+	const Vector4& v1{ triangle.v1 };
+	const Vector4& v2{ triangle.v2 };
+	const VertexOutputStreams& streams{ *triangle.pVertexStreams };
+
+	//Multiplied by the reciprocals of w instead of divided, like the block kernels in that mode
+	if constexpr (Shader::useFastMath)
+	{
+		const float inverseW0{ FastMath::Reciprocal(v0.w) };
+		const float inverseW1{ FastMath::Reciprocal(v1.w) };
+		const float inverseW2{ FastMath::Reciprocal(v2.w) };
+		wInterpolated = FastMath::Reciprocal(barycentrics.x * inverseW0 + barycentrics.y * inverseW1 + barycentrics.z * inverseW2);
+
+		const Vector2 uv0{ barycentrics.x * (streams.GetUV(triangle.vertexIndices[0]) * inverseW0) };
+		const Vector2 uv1{ barycentrics.y * (streams.GetUV(triangle.vertexIndices[1]) * inverseW1) };
+		const Vector2 uv2{ barycentrics.z * (streams.GetUV(triangle.vertexIndices[2]) * inverseW2) };
+		uv = (uv0 + uv1 + uv2) * wInterpolated;
+		return;
+	}
+
+	//W value
+	const float w0{ barycentrics.x / v0.w };
+	const float w1{ barycentrics.y / v1.w };
+	const float w2{ barycentrics.z / v2.w };
+	wInterpolated = 1 / (w0 + w1 + w2);
+
+	//interpolated UV
+	const Vector2 uv0{ barycentrics.x * (streams.GetUV(triangle.vertexIndices[0]) / v0.w) };
+	const Vector2 uv1{ barycentrics.y * (streams.GetUV(triangle.vertexIndices[1]) / v1.w) };
+	const Vector2 uv2{ barycentrics.z * (streams.GetUV(triangle.vertexIndices[2]) / v2.w) };
+	uv = (uv0 + uv1 + uv2) * wInterpolated;
+}
+template<typename Shader>
+void Renderer::ShadeFragment(const int px, const int py, const ScreenTriangle& triangle, const Vector3& barycentrics,
+	const float depth, const float wInterpolated, const Vector2& uv, TileStatistics& statistics)
+{
+	const int pixelNr{ px + (m_BufferWidth * py) };
+	const VertexOutputStreams& streams{ *triangle.pVertexStreams };
+	const uint32_t* vertexIndices{ triangle.vertexIndices };
+
+	//Create a new vertex out with all the interpolated value
+	Vertex_Out interpolatedVertex
+	{
+		Vector4{triangle.v0.x, triangle.v0.y, depth, wInterpolated},
+		ColorRGB{},
+		uv
+	};
+
+	if constexpr (!Shader::displayDepth)
+	{
+		//calculate interpolated normal
+		const Vector3 n0{ barycentrics.x * streams.GetNormal(vertexIndices[0]) };
+		const Vector3 n1{ barycentrics.y * streams.GetNormal(vertexIndices[1]) };
+		const Vector3 n2{ barycentrics.z * streams.GetNormal(vertexIndices[2]) };
+		interpolatedVertex.normal = NormalizeDirection<Shader>(n0 + n1 + n2);
+	}
+
+	if constexpr (Shader::needsTangent)
+	{
+		//calculate interpolated tangent
+		const Vector3 t0{ barycentrics.x * streams.GetTangent(vertexIndices[0]) };
+		const Vector3 t1{ barycentrics.y * streams.GetTangent(vertexIndices[1]) };
+		const Vector3 t2{ barycentrics.z * streams.GetTangent(vertexIndices[2]) };
+		interpolatedVertex.tangent = NormalizeDirection<Shader>(t0 + t1 + t2);
+	}
+
+	if constexpr (Shader::needsViewDirection)
+	{
+		//calculate interpolated viewDirection
+		const Vector3 view0{ barycentrics.x * streams.GetViewDirection(vertexIndices[0]) };
+		const Vector3 view1{ barycentrics.y * streams.GetViewDirection(vertexIndices[1]) };
+		const Vector3 view2{ barycentrics.z * streams.GetViewDirection(vertexIndices[2]) };
+		interpolatedVertex.viewDirection = NormalizeDirection<Shader>(view0 + view1 + view2);
+	}
+
+	++statistics.counters.pixelsShaded;
+	if (m_Profiler.IsEnabled())
+	{
+		const FrameProfiler::Clock::time_point start{ FrameProfiler::Clock::now() };
+		ShadePixel<Shader>(pixelNr, interpolatedVertex, GetTextureGradient<Shader>(triangle, px, py));
+		statistics.shadingMs += FrameProfiler::ToMilliseconds(FrameProfiler::Clock::now() - start);
+	}
+	else
+	{
+		ShadePixel<Shader>(pixelNr, interpolatedVertex, GetTextureGradient<Shader>(triangle, px, py));
+	}
+}
+template<typename Shader>
+void Renderer::ShadeVisibilityBuffer(const Tile& tile, PixelKernel::BlockFunction blockFunction, TileStatistics& statistics)
+{
+	if (!blockFunction)
+	{
+		for (int py{ tile.minY }; py < tile.maxY; ++py)
+		{
+			for (int px{ tile.minX }; px < tile.maxX; ++px)
+			{
+				ShadeVisibilityPixel<Shader>(px, py, tile.minX + ((px - tile.minX) & ~(PixelBlock::size - 1)), statistics);
+			}
+		}
+		return;
+	}
+
+	const bool isProfiling{ m_Profiler.IsEnabled() };
+
+	//Every pixel stored in the visibility buffer passes the depth test of the kernel
+	alignas(32) float passingDepth[PixelBlock::size];
+	std::fill_n(passingDepth, PixelBlock::size, FLT_MAX);
+
+	KernelTriangle kernelTriangle{};
+	uint32_t kernelTriangleIndex{ m_NoTriangle };
+	PixelBlock block{};
+
+	for (int py{ tile.minY }; py < tile.maxY; ++py)
+	{
+		for (int px{ tile.minX }; px < tile.maxX; px += PixelBlock::size)
+		{
+			const int count{ std::min(PixelBlock::size, tile.maxX - px) };
+			const uint32_t* pTriangleIndices{ m_pVisibilityBufferPixels + px + py * m_BufferWidth };
+
+			uint32_t remainingMask{};
+			for (int lane{ 0 }; lane < count; ++lane)
+			{
+				if (pTriangleIndices[lane] != m_NoTriangle) remainingMask |= 1u << lane;
+			}
+
+			const bool isTimed{ isProfiling && remainingMask };
+			const FrameProfiler::Clock::time_point shadingStart{ isTimed ? FrameProfiler::Clock::now() : FrameProfiler::Clock::time_point{} };
+
+			while (remainingMask)
+			{
+				//All the lanes showing the same triangle as the first remaining one
+				const uint32_t triangleIndex{ pTriangleIndices[std::countr_zero(remainingMask)] };
+				uint32_t triangleMask{};
+				for (uint32_t laneMask{ remainingMask }; laneMask; laneMask &= laneMask - 1)
+				{
+					const int lane{ std::countr_zero(laneMask) };
+					if (pTriangleIndices[lane] == triangleIndex) triangleMask |= 1u << lane;
+				}
+				remainingMask &= ~triangleMask;
+
+				const ScreenTriangle& triangle{ m_pRasterizedFrame->triangles[triangleIndex] };
+				if (triangleIndex != kernelTriangleIndex)
+				{
+					kernelTriangle = GetKernelTriangle(triangle, Shader::useFastMath);
+					kernelTriangleIndex = triangleIndex;
+				}
+
+				const Vector3 rowWeights{ GetEdgeWeights(triangle, px, py) };
+				blockFunction(kernelTriangle, rowWeights, 0.0f, passingDepth, count, !Shader::displayDepth, Shader::useFastMath, block);
+
+				statistics.counters.pixelsShaded += std::popcount(triangleMask & block.visibleMask);
+				for (uint32_t laneMask{ triangleMask & block.visibleMask }; laneMask; laneMask &= laneMask - 1)
+				{
+					ShadeBlockLane<Shader>(triangle, block, std::countr_zero(laneMask), px, py);
+				}
+
+				//Pixels on the edge can be rejected by a rounding difference with the first pass
+				for (uint32_t laneMask{ triangleMask & ~block.visibleMask }; laneMask; laneMask &= laneMask - 1)
+				{
+					ShadeVisibilityPixel<Shader>(px + std::countr_zero(laneMask), py, px, statistics);
+				}
+			}
+
+			if (isTimed) statistics.shadingMs += FrameProfiler::ToMilliseconds(FrameProfiler::Clock::now() - shadingStart);
+		}
+	}
+}
+template<typename Shader>
+void Renderer::ShadeVisibilityBufferCoarse(const Tile& tile, const int shadingRate, TileStatistics& statistics)
+{
+	//The shaded pixels time themselves, like the scalar path
+	const float blockCenter{ 0.5f * (shadingRate - 1) };
+
+	for (int blockY{ tile.minY }; blockY < tile.maxY; blockY += shadingRate)
+	{
+		for (int blockX{ tile.minX }; blockX < tile.maxX; blockX += shadingRate)
+		{
+			//The blocks at the border of the screen can be smaller
+			const int width{ std::min(shadingRate, tile.maxX - blockX) };
+			const int height{ std::min(shadingRate, tile.maxY - blockY) };
+
+			//At most 4x4 pixels, one bit per pixel in row order
+			uint32_t triangleIndices[16]{};
+			uint32_t remainingMask{};
+			for (int y{ 0 }; y < height; ++y)
+			{
+				for (int x{ 0 }; x < width; ++x)
+				{
+					const int pixel{ x + y * shadingRate };
+					triangleIndices[pixel] = m_pVisibilityBufferPixels[blockX + x + (blockY + y) * m_BufferWidth];
+					if (triangleIndices[pixel] != m_NoTriangle) remainingMask |= 1u << pixel;
+				}
+			}
+
+			while (remainingMask)
+			{
+				//The pixels of the same triangle get the color of its pixel closest to the center of the block
+				const uint32_t triangleIndex{ triangleIndices[std::countr_zero(remainingMask)] };
+				uint32_t triangleMask{};
+				int samplePixel{};
+				float sampleDistance{ FLT_MAX };
+				for (uint32_t pixelMask{ remainingMask }; pixelMask; pixelMask &= pixelMask - 1)
+				{
+					const int pixel{ std::countr_zero(pixelMask) };
+					if (triangleIndices[pixel] != triangleIndex) continue;
+					triangleMask |= 1u << pixel;
+
+					const float distance{ std::abs(pixel % shadingRate - blockCenter) + std::abs(pixel / shadingRate - blockCenter) };
+					if (distance < sampleDistance)
+					{
+						sampleDistance = distance;
+						samplePixel = pixel;
+					}
+				}
+				remainingMask &= ~triangleMask;
+
+				const int samplePixelNr{ blockX + samplePixel % shadingRate + (blockY + samplePixel / shadingRate) * m_BufferWidth };
+				const int sampleX{ blockX + samplePixel % shadingRate };
+				ShadeVisibilityPixel<Shader>(sampleX, blockY + samplePixel / shadingRate, sampleX, statistics);
+
+				const uint32_t color{ m_pBackBufferPixels[samplePixelNr] };
+				for (uint32_t pixelMask{ triangleMask & ~(1u << samplePixel) }; pixelMask; pixelMask &= pixelMask - 1)
+				{
+					const int pixel{ std::countr_zero(pixelMask) };
+					m_pBackBufferPixels[blockX + pixel % shadingRate + (blockY + pixel / shadingRate) * m_BufferWidth] = color;
+				}
+			}
+		}
+	}
+}
+template<typename Shader>
+void Renderer::ShadeVisibilityPixel(const int px, const int py, const int firstX, TileStatistics& statistics)
+{
+	const int pixelNr{ px + (m_BufferWidth * py) };
+	const uint32_t triangleIndex{ m_pVisibilityBufferPixels[pixelNr] };
+	if (triangleIndex == m_NoTriangle) return;
+
+	//The edge functions are linear, the barycentrics come straight from the triangle setup
+	//Stepped in float from the start of the block exactly like the block kernels, the edge values are too large to convert them per pixel
+	const ScreenTriangle& triangle{ m_pRasterizedFrame->triangles[triangleIndex] };
+	const Vector3 weights{ GetEdgeWeights(triangle, firstX, py) + triangle.edgeStepXFloat * static_cast<float>(px - firstX) };
+	const Vector3 barycentrics{ weights * triangle.inverseArea };
+
+	float wInterpolated{};
+	Vector2 interpolatedUV{};
+	InterpolatePerspective<Shader>(triangle, barycentrics, wInterpolated, interpolatedUV);
+
+	ShadeFragment<Shader>(px, py, triangle, barycentrics, m_pDepthBufferPixels[pixelNr], wInterpolated, interpolatedUV, statistics);
+}
+template<typename Shader>
+void Renderer::ShadePixel(const int pixelNr, Vertex_Out& interpolatedVertex, const TextureGradient& gradient)
+{
+	ColorRGB finalColor{};
+
+	if constexpr (!Shader::displayDepth)
+	{
+		//Get all the map values in one fetch, the observed area without normal map doesn't read any
+		MaterialSample material{};
+		if constexpr (Shader::needsMaterial)
+		{
+			material = SampleMaterial(interpolatedVertex.uv, gradient);
+		}
+		interpolatedVertex.color = material.diffuse;
+
+		//Shade the pixel
+		finalColor = PixelShading<Shader>(interpolatedVertex, material);
+	}
+	else
+	{
+		//Display Z buffer values
+		const float mappedValue{ Remap(interpolatedVertex.position.z,0.985f, 1.0f) };
+		finalColor = ColorRGB{ mappedValue,mappedValue,mappedValue };
+	}
+
+	//Update Color in Buffer
+	finalColor.MaxToOne();
+
+	m_pBackBufferPixels[pixelNr] = SDL_MapRGB(m_pBackBuffer->format,
+		static_cast<uint8_t>(finalColor.r * 255),
+		static_cast<uint8_t>(finalColor.g * 255),
+		static_cast<uint8_t>(finalColor.b * 255));
+}
+void Renderer::RenderMeshes(Scene& scene)
+{
+	//Pipelined, the tiles of the last frame are still rasterized meanwhile
+	if (!m_UsePipelining) WaitForFrame();
+	const bool isRendered{ PrepareFrame(scene) };
+	WaitForFrame();
+	if (!isRendered) return;
+
+	FrameData& frame{ *m_pPreparedFrame };
+	if (&frame != m_pRasterizedFrame) KeepUnchangedTiles(frame, *m_pRasterizedFrame);
+
+	//Pipelined, the back buffer of this frame data still holds the frame before the last one in its dirty tiles
+	m_pHistoryFrame = m_pRasterizedFrame;
+
+	//The shading options don't change during the frame, pick the specialized functions once
+	m_pRasterizedFrame = &frame;
+	m_pBackBuffer = frame.pBackBuffer;
+	m_pBackBufferPixels = (uint32_t*)m_pBackBuffer->pixels;
+	m_RasterizedTileFunction = GetTileFunction();
+
+	if (m_UsePipelining)
+	{
+		{
+			std::lock_guard lock{ m_RasterMutex };
+			m_IsRasterizing = true;
+		}
+		m_RasterRequested.notify_one();
+		m_HasFrameInFlight = true;
+	}
+	else
+	{
+		RasterizeFrame();
+		m_pFrameToPresent = &frame;
+	}
+}
+bool Renderer::PrepareFrame(Scene& scene)
+{
+	//Pipelined, the other frame data is still read by the tile workers
+	FrameData* pOtherFrame{ m_pRasterizedFrame == &m_Frames[0] ? &m_Frames[1] : &m_Frames[0] };
+	m_pPreparedFrame = m_UsePipelining ? pOtherFrame : m_pRasterizedFrame;
+	FrameData& frame{ *m_pPreparedFrame };
+	const std::vector<MeshInstance>& instances{ scene.GetInstances() };
+
+	//Nothing moved and the options are the same, the back buffer already holds this frame
+	const bool isReusingFrame{ UpdateFrameState(instances) };
+	const bool isStill{ isReusingFrame && std::none_of(m_InstanceStates.begin(), m_InstanceStates.end(), [](const InstanceFrameState& state) { return state.isMoved; }) };
+
+	//A still coarse frame is rendered once more at full rate, so the picture left on screen has every detail
+	//The shading rates of the last frame are only known once its tiles are done
+	if (isStill) WaitForFrame();
+	const std::vector<Tile>& lastTiles{ m_pRasterizedFrame->tiles };
+	const bool hasCoarseTiles{ isStill && std::any_of(lastTiles.begin(), lastTiles.end(), [](const Tile& tile) { return tile.shadingRate > 1; }) };
+	frame.useFullShadingRate = hasCoarseTiles;
+
+	m_WasFrameSkipped = isStill && !hasCoarseTiles;
+	if (m_WasFrameSkipped)
+	{
+		m_Profiler.AddCounters(FrameCounters{});
+		return false;
+	}
+
+	//The tile workers are done with this frame data, nothing points in its arena anymore
+	frame.arena.Reset();
+	frame.counters = FrameCounters{};
+	frame.width = m_Width;
+	frame.height = m_Height;
+	{
+		ScopedStageTimer timer{ m_Profiler, ProfileStage::VertexTransformation };
+
+		//Whole instances outside of the view are neither transformed nor binned
+		scene.UpdateBounds();
+		const Frustum frustum{ Frustum::FromViewProjection(m_Camera.viewMatrix * m_Camera.projectionMatrix) };
+		frame.counters.instancesCulled = instances.size() - scene.CullInstances(frustum, m_IsInstanceVisible);
+		SelectLods(scene);
+
+		VertexTransformationFunction(instances);
+	}
+	{
+		ScopedStageTimer timer{ m_Profiler, ProfileStage::ScreenSpace };
+		BinTriangles(instances);
+	}
+
+	//Everything the frame allocated is in the arena, after the first frames it doesn't grow anymore
+	const LinearArena::Statistics arenaStatistics{ frame.arena.GetStatistics() };
+	frame.counters.arenaAllocations = arenaStatistics.nrAllocations;
+	frame.counters.arenaBytesUsed = arenaStatistics.bytesUsed;
+	frame.counters.arenaBytesReserved = arenaStatistics.bytesReserved;
+	frame.counters.arenaHeapAllocations = arenaStatistics.nrHeapAllocations;
+	frame.counters.tilesRendered = MarkDirtyTiles(isReusingFrame && !hasCoarseTiles);
+	return true;
+}
+void Renderer::RasterizeFrame()
+{
+	FrameData& frame{ *m_pRasterizedFrame };
+	const TileFunction renderTile{ m_RasterizedTileFunction };
+
+	//Every tile owns its part of the buffers, so the workers never write to the same pixel
+	SDL_LockSurface(frame.pBackBuffer);
+	std::for_each(std::execution::par, frame.tiles.begin(), frame.tiles.end(), [this, renderTile](Tile& tile)
+		{
+			if (tile.isDirty) (this->*renderTile)(tile);
+			else tile.statistics = TileStatistics{};
+		});
+	SDL_UnlockSurface(frame.pBackBuffer);
+}
+void Renderer::KeepUnchangedTiles(FrameData& frame, const FrameData& lastFrame) const
+{
+	//Both frame data have the same tiles, InitTiles changes them together
+	const uint32_t* pLastPixels{ (const uint32_t*)lastFrame.pBackBuffer->pixels };
+	uint32_t* pPixels{ (uint32_t*)frame.pBackBuffer->pixels };
+	for (size_t tileIndex{ 0 }; tileIndex < frame.tiles.size(); ++tileIndex)
+	{
+		Tile& tile{ frame.tiles[tileIndex] };
+		if (tile.isDirty) continue;
+
+		const Tile& lastTile{ lastFrame.tiles[tileIndex] };
+		for (int py{ tile.minY }; py < tile.maxY; ++py)
+		{
+			const int rowStart{ tile.minX + py * m_BufferWidth };
+			std::copy(pLastPixels + rowStart, pLastPixels + rowStart + (tile.maxX - tile.minX), pPixels + rowStart);
+		}
+		tile.shadingRate = lastTile.shadingRate;
+		tile.hasHistory = lastTile.hasHistory;
+	}
+}
+void Renderer::AddFrameStatistics(const FrameData& frame)
+{
+	//The tile times are summed over the workers, so they are cpu time and not wall time
+	FrameCounters counters{ frame.counters };
+	for (const Tile& tile : frame.tiles)
+	{
+		m_Profiler.AddStageTime(ProfileStage::Clear, tile.statistics.clearMs);
+		m_Profiler.AddStageTime(ProfileStage::Rasterization, tile.statistics.rasterizationMs);
+		m_Profiler.AddStageTime(ProfileStage::PixelShading, tile.statistics.shadingMs);
+		counters += tile.statistics.counters;
+	}
+	m_Profiler.AddCounters(counters);
+}
+
+float Renderer::GetLodPixelsPerUnit() const
+{
+	//The projection scales y by 1 / tan(fov / 2), and the screen is 2 of those units high
+	return m_Camera.projectionMatrix[1][1] * m_Height * 0.5f;
+}
+void Renderer::SelectLods(const Scene& scene)
+{
+	static_assert(MeshSimplifier::maxNrLods <= FrameCounters::maxNrLods, "The counters need an entry for every level");
+
+	const std::vector<MeshInstance>& instances{ scene.GetInstances() };
+	const std::vector<BoundingBox>& instanceBounds{ scene.GetInstanceBounds() };
+	FrameCounters& counters{ m_pPreparedFrame->counters };
+	const float pixelsPerUnit{ GetLodPixelsPerUnit() };
+
+	m_InstanceLods.resize(instances.size());
+	for (size_t instanceIndex{ 0 }; instanceIndex < instances.size(); ++instanceIndex)
+	{
+		if (!m_IsInstanceVisible[instanceIndex]) continue;
+		const MeshInstance& instance{ instances[instanceIndex] };
+		const std::vector<MeshLod>& lods{ instance.pMesh->lods };
+
+		//The error is projected at the closest point of the instance, the part that shows it the most
+		size_t lod{ 0 };
+		if (m_UseLevelOfDetail)
+		{
+			const float distance{ GetDistance(instanceBounds[instanceIndex], m_Camera.origin) };
+			const float maxError{ m_MaxLodPixelError * distance / (pixelsPerUnit * GetMaxScale(instance.worldMatrix)) };
+			while (lod + 1 < lods.size() && lods[lod + 1].error <= maxError) ++lod;
+		}
+		m_InstanceLods[instanceIndex] = static_cast<uint8_t>(lod);
+
+		++counters.instancesPerLod[lod];
+		counters.trianglesPerLod[lod] += GetNrTriangles(*instance.pMesh, lod);
+	}
+}
+bool Renderer::UpdateFrameState(const std::vector<MeshInstance>& instances)
+{
+	const FrameStateKey frameState{ GetFrameStateKey() };
+	const bool isReusingFrame{ m_UseFrameReuse && m_HasFrameState && frameState == m_FrameState && m_InstanceStates.size() == instances.size() };
+	m_FrameState = frameState;
+	m_HasFrameState = true;
+
+	//Only allocates when instances are added
+	m_InstanceStates.resize(instances.size());
+	for (size_t instanceIndex{ 0 }; instanceIndex < instances.size(); ++instanceIndex)
+	{
+		InstanceFrameState& state{ m_InstanceStates[instanceIndex] };
+		const Matrix& worldMatrix{ instances[instanceIndex].worldMatrix };
+
+		//The bits and not the values, an instance set to the same transform again doesn't move
+		state.isMoved = !isReusingFrame || std::memcmp(&state.worldMatrix, &worldMatrix, sizeof(Matrix)) != 0;
+		state.worldMatrix = worldMatrix;
+		if (state.isMoved) ++state.version;
+	}
+	return isReusingFrame;
+}
+FrameStateKey Renderer::GetFrameStateKey() const
+{
+	FrameStateKey key{};
+	key.viewMatrix = m_Camera.viewMatrix;
+	key.projectionMatrix = m_Camera.projectionMatrix;
+	key.width = m_Width;
+	key.height = m_Height;
+	key.displayZBuffer = m_DisplayZBuffer;
+	key.displayNormalMap = m_DisplayNormalMap;
+	key.shadingMode = m_ShadingMode;
+	key.pixelKernel = m_PixelKernel;
+	key.textureFilter = m_TextureFilter;
+	key.useVisibilityBuffer = m_UseVisibilityBuffer;
+	key.isBackFaceCullingEnabled = m_IsBackFaceCullingEnabled;
+	key.useHierarchicalDepth = m_UseHierarchicalDepth;
+	key.shadingRate = m_ShadingRate;
+	key.useLevelOfDetail = m_UseLevelOfDetail;
+	key.vertexFormat = m_Scene.GetVertexFormat();
+	key.mathMode = m_MathMode;
+	return key;
+}
+int Renderer::MarkDirtyTiles(const bool isReusingFrame)
+{
+	int nrDirtyTiles{ 0 };
+	for (Tile& tile : m_pPreparedFrame->tiles)
+	{
+		tile.isDirty = !isReusingFrame;
+		if (!tile.isDirty)
+		{
+			//Where the moved instances were and where they are now
+			const ScreenRect tileRect{ tile.minX, tile.minY, tile.maxX, tile.maxY };
+			for (const InstanceFrameState& state : m_InstanceStates)
+			{
+				if (state.isMoved && (state.bounds.Overlaps(tileRect) || state.previousBounds.Overlaps(tileRect)))
+				{
+					tile.isDirty = true;
+					break;
+				}
+			}
+		}
+		nrDirtyTiles += tile.isDirty;
+	}
+	return nrDirtyTiles;
+}
+
+void Renderer::InitTiles()
+{
+	for (FrameData& frame : m_Frames)
+	{
+		frame.tiles.clear();
+		for (int y{ 0 }; y < m_Height; y += m_TileSize)
+		{
+			for (int x{ 0 }; x < m_Width; x += m_TileSize)
+			{
+				Tile tile{};
+				tile.minX = x;
+				tile.minY = y;
+				tile.maxX = std::min(x + m_TileSize, m_Width);
+				tile.maxY = std::min(y + m_TileSize, m_Height);
+				frame.tiles.push_back(tile);
+			}
+		}
+	}
+}
+
+void Renderer::BinTriangles(const std::vector<MeshInstance>& instances)
+{
+	FrameData& frame{ *m_pPreparedFrame };
+	FrameCounters& counters{ frame.counters };
+	LinearArena& arena{ frame.arena.GetMainArena() };
+	frame.clippedVertices.Clear();
+
+	//Split every instance in chunks of triangles, so a single big mesh still uses all the workers
+	size_t nrChunks{ 0 };
+	for (size_t instanceIndex{ 0 }; instanceIndex < instances.size(); ++instanceIndex)
+	{
+		if (!m_IsInstanceVisible[instanceIndex]) continue;
+		nrChunks += (GetNrTriangles(*instances[instanceIndex].pMesh, m_InstanceLods[instanceIndex]) + m_BinningChunkSize - 1) / m_BinningChunkSize;
+	}
+
+	const std::span<BinningChunk> chunks{ arena.Allocate<BinningChunk>(nrChunks) };
+	size_t chunkIndex{ 0 };
+	for (size_t instanceIndex{ 0 }; instanceIndex < instances.size(); ++instanceIndex)
+	{
+		if (!m_IsInstanceVisible[instanceIndex]) continue;
+		const size_t nrTriangles{ GetNrTriangles(*instances[instanceIndex].pMesh, m_InstanceLods[instanceIndex]) };
+		for (size_t first{ 0 }; first < nrTriangles; first += m_BinningChunkSize)
+		{
+			chunks[chunkIndex++] = { instanceIndex, first, std::min(first + m_BinningChunkSize, nrTriangles) };
+		}
+	}
+
+	std::for_each(std::execution::par, chunks.begin(), chunks.end(), [this, &instances](BinningChunk& chunk)
+		{
+			BinTriangleChunk(chunk, instances);
+		});
+
+	//A clipped triangle becomes at most a fan of maxPolygonSize - 2 triangles
+	size_t maxNrTriangles{ 0 };
+	for (const BinningChunk& chunk : chunks)
+	{
+		maxNrTriangles += chunk.triangles.size() + chunk.counters.trianglesClipped * (Clipper::maxPolygonSize - 3);
+	}
+	frame.triangles = arena.Allocate<ScreenTriangle>(maxNrTriangles);
+
+	//Every instance is binned again, the tiles it covers might be rendered for another one
+	for (InstanceFrameState& state : m_InstanceStates)
+	{
+		state.previousBounds = state.bounds;
+		state.bounds = ScreenRect{};
+	}
 
-#include<execution>
+	//Merged in submission order, the clipping is done here since the clipped vertices are shared by the whole frame
+	size_t nrTriangles{ 0 };
+	for (const BinningChunk& chunk : chunks)
+	{
+		ScreenRect& bounds{ m_InstanceStates[chunk.instanceIndex].bounds };
+		bounds.Add(chunk.bounds);
+		counters += chunk.counters;
 
-using namespace dae;
+		for (const BinnedTriangle& binnedTriangle : chunk.triangles)
+		{
+			if (binnedTriangle.clippingPlanes) AddClippedTriangles(binnedTriangle.triangle, binnedTriangle.clippingPlanes, bounds, nrTriangles);
+			else frame.triangles[nrTriangles++] = binnedTriangle.triangle;
+		}
+	}
+	frame.triangles = frame.triangles.first(nrTriangles);
+	counters.trianglesRasterized = nrTriangles;
 
-Renderer::Renderer(SDL_Window* pWindow) :
-	m_pWindow(pWindow)
+	FillTileTriangles(frame);
+}
+
+void Renderer::BinTriangleChunk(BinningChunk& chunk, const std::vector<MeshInstance>& instances) const
 {
-	//Initialize
-	SDL_GetWindowSize(pWindow, &m_Width, &m_Height);
+	const MeshData& mesh{ *instances[chunk.instanceIndex].pMesh };
+	const std::span<const uint32_t> indices{ mesh.GetIndices(m_InstanceLods[chunk.instanceIndex]) };
+	FrameCounters& counters{ chunk.counters };
 
-	//Create Buffers
-	m_pFrontBuffer = SDL_GetWindowSurface(pWindow);
-	m_pBackBuffer = SDL_CreateRGBSurface(0, m_Width, m_Height, 32, 0, 0, 0, 0);
-	m_pBackBufferPixels = (uint32_t*)m_pBackBuffer->pixels;
-	m_pDepthBufferPixels = new float[m_Width * m_Height];
+	//The vertex kernel already found the screen positions and the planes the vertices are outside of
+	const VertexOutputStreams& streams{ m_pPreparedFrame->instanceVertices[chunk.instanceIndex].streams };
 
-	//Initialize Camera
-	m_Camera.Initialize(45.f, { .0f,5.0f,-64.f });
-	m_Camera.aspectRatio = static_cast<float>(m_Width) / m_Height;
+	//At most one per triangle, only kept until the chunks are merged
+	const std::span<BinnedTriangle> binnedTriangles{ m_pPreparedFrame->arena.GetThreadArena().Allocate<BinnedTriangle>(chunk.lastTriangle - chunk.firstTriangle) };
+	size_t nrBinnedTriangles{ 0 };
 
-	//InitTexture
-	m_pTexture = Texture::LoadFromFile("Resources/vehicle_diffuse.png");
-	m_pNormalMap = Texture::LoadFromFile("Resources/vehicle_normal.png");
-	m_pGlossyMap = Texture::LoadFromFile("Resources/vehicle_gloss.png");
-	m_pSpecularMap = Texture::LoadFromFile("Resources/vehicle_specular.png");
+	//Determine how we will iterate through the indices dending of the mesh topology
+	const size_t incrementIndex{ mesh.primitiveTopology == PrimitiveTopology::TriangleList ? 3u : 1u };
 
-	//Init shape
-	Utils::ParseOBJ("Resources/vehicle.obj", m_MeshVetrices, m_MeshIndices);
-	m_NonTransformedMeshes.push_back(Mesh{ {m_MeshVetrices}, m_MeshIndices, PrimitiveTopology::TriangleList });
-}
-Renderer::~Renderer()
-{
-	delete m_pTexture;
-	delete m_pNormalMap;
+	for (size_t triangleNr{ chunk.firstTriangle }; triangleNr < chunk.lastTriangle; ++triangleNr)
+	{
+		const size_t index{ triangleNr * incrementIndex };
+		const uint32_t vertexIndices[3]{ indices[index], indices[index + 1], indices[index + 2] };
+		const uint8_t outsidePlanes[3]
+		{
+			streams.pOutsidePlanes[vertexIndices[0]],
+			streams.pOutsidePlanes[vertexIndices[1]],
+			streams.pOutsidePlanes[vertexIndices[2]]
+		};
 
-	delete m_pGlossyMap;
-	delete m_pSpecularMap;
+		//All the vertices outside of the same plane of the frustum --> we don't display the triangle
+		if (outsidePlanes[0] & outsidePlanes[1] & outsidePlanes[2] & Clipper::frustumPlanes)
+		{
+			++counters.trianglesCulled;
+			continue;
+		}
 
-	delete[] m_pDepthBufferPixels;
-}
+		if (m_IsBackFaceCullingEnabled)
+		{
+			//Every other triangle of a strip has its vertices in the opposite order
+			const bool isFlipped{ mesh.primitiveTopology == PrimitiveTopology::TriangleStrip && (index & 1) };
+			const float winding{ Clipper::GetWinding(streams.GetPosition(vertexIndices[0]), streams.GetPosition(vertexIndices[1]), streams.GetPosition(vertexIndices[2])) };
+			if (isFlipped ? winding <= 0 : winding >= 0)
+			{
+				++counters.trianglesBackFacing;
+				continue;
+			}
+		}
 
-void Renderer::Update(Timer* pTimer)
-{
-	m_Camera.Update(pTimer);
+		BinnedTriangle binnedTriangle{};
+		ScreenTriangle& triangle{ binnedTriangle.triangle };
+		triangle.pVertexStreams = &streams;
+		for (int i{ 0 }; i < 3; ++i)
+		{
+			triangle.vertexIndices[i] = vertexIndices[i];
+		}
 
-	UpdateRotation(pTimer);	
+		//Crossing the near plane or leaving the guard band, split the visible part in new triangles when merging
+		if ((outsidePlanes[0] | outsidePlanes[1] | outsidePlanes[2]) & Clipper::clippingPlanes)
+		{
+			++counters.trianglesClipped;
+			binnedTriangle.clippingPlanes = outsidePlanes[0] | outsidePlanes[1] | outsidePlanes[2];
+			binnedTriangles[nrBinnedTriangles++] = binnedTriangle;
+			continue;
+		}
+
+		//Calculate the value of the three vetrices
+		triangle.v0 = streams.GetScreenPosition(vertexIndices[0]);
+		triangle.v1 = streams.GetScreenPosition(vertexIndices[1]);
+		triangle.v2 = streams.GetScreenPosition(vertexIndices[2]);
+
+		if (!PrepareTriangle(triangle))
+		{
+			++counters.trianglesCulled;
+			continue;
+		}
+
+		//No pixel outside of the bounding box is written
+		chunk.bounds.Add({ triangle.minX, triangle.minY, triangle.maxX, triangle.maxY });
+		binnedTriangles[nrBinnedTriangles++] = binnedTriangle;
+	}
+	chunk.triangles = binnedTriangles.first(nrBinnedTriangles);
 }
-void Renderer::UpdateRotation(Timer* pTimer)
+
+void Renderer::AddClippedTriangles(const ScreenTriangle& triangle, const uint8_t outsidePlanes, ScreenRect& bounds, size_t& nrTriangles)
 {
-	//Update the rotation Angle
-	if (m_IsRotationEnabled)
+	const VertexOutputStreams& streams{ *triangle.pVertexStreams };
+	const uint32_t* vertexIndices{ triangle.vertexIndices };
+	const Vertex_Out vertices[3]{ streams.GetVertex(vertexIndices[0]), streams.GetVertex(vertexIndices[1]), streams.GetVertex(vertexIndices[2]) };
+	const Vertex_Out* pTriangle[3]{ &vertices[0], &vertices[1], &vertices[2] };
+
+	FrameData& frame{ *m_pPreparedFrame };
+	Vertex_Out polygon[Clipper::maxPolygonSize]{};
+	const int nrVertices{ Clipper::ClipTriangle(pTriangle, outsidePlanes, polygon) };
+	if (nrVertices < 3)
 	{
-		m_MeshRotationAngle += m_MeshRotationSpeed * pTimer->GetElapsed();
+		++frame.counters.trianglesCulled;
+		return;
 	}
-}
 
-void Renderer::Render()
-{
-	//@START
-	//Lock BackBuffer
-	SDL_LockSurface(m_pBackBuffer);
+	//The new vertices live until the end of the frame, the triangles keep their index so the streams can grow
+	VertexOutputStreams& clippedVertices{ frame.clippedVertices };
+	uint32_t polygonIndices[Clipper::maxPolygonSize]{};
+	for (int i{ 0 }; i < nrVertices; ++i)
+	{
+		polygonIndices[i] = clippedVertices.Add(polygon[i], ToScreenPosition(polygon[i].position));
+	}
 
-	//Functions
-	//All the functions from the previous weeks were deleted to keep the code cleaner
-	//You can find them on my GitHub page :
-	//https://github.com/AlexandreBeeckmans/Rasterizer
+	//The polygon is convex, a fan keeps the winding of the original triangle
+	for (int i{ 1 }; i + 1 < nrVertices; ++i)
+	{
+		ScreenTriangle clippedTriangle{};
+		clippedTriangle.pVertexStreams = &clippedVertices;
+		clippedTriangle.vertexIndices[0] = polygonIndices[0];
+		clippedTriangle.vertexIndices[1] = polygonIndices[i];
+		clippedTriangle.vertexIndices[2] = polygonIndices[i + 1];
 
-	Render_W4_Part1();
+		clippedTriangle.v0 = clippedVertices.GetScreenPosition(polygonIndices[0]);
+		clippedTriangle.v1 = clippedVertices.GetScreenPosition(polygonIndices[i]);
+		clippedTriangle.v2 = clippedVertices.GetScreenPosition(polygonIndices[i + 1]);
 
-	//@END
-	//Update SDL Surface
-	SDL_UnlockSurface(m_pBackBuffer);
-	SDL_BlitSurface(m_pBackBuffer, 0, m_pFrontBuffer, 0);
-	SDL_UpdateWindowSurface(m_pWindow);
+		if (!PrepareTriangle(clippedTriangle))
+		{
+			++frame.counters.trianglesCulled;
+			continue;
+		}
+
+		bounds.Add({ clippedTriangle.minX, clippedTriangle.minY, clippedTriangle.maxX, clippedTriangle.maxY });
+		frame.triangles[nrTriangles++] = clippedTriangle;
+	}
 }
 
-//Vertex transformation
-void Renderer::VertexTransformationFunction(std::vector<Mesh>& meshVector) const
+bool Renderer::PrepareTriangle(ScreenTriangle& triangle) const
 {
-	//Calculate this matrix before the for loop to reduce the amount of operation inside of this loop
-	const Matrix viewProjectionMatrix{ m_Camera.viewMatrix * m_Camera.projectionMatrix };
-	for (Mesh& mesh : meshVector)
+	const Vector4& v0{ triangle.v0 };
+	const Vector4& v1{ triangle.v1 };
+	const Vector4& v2{ triangle.v2 };
+
+	//Define triangle bounding box
+	const Vector2 topLeft
 	{
-		const Matrix worldViewProjectionMatrix{ mesh.worldMatrix *  viewProjectionMatrix };
-		for (const Vertex& vertex : mesh.vertices)
-		{
-			//New position with perspective division
-			Vector4 newPos{ worldViewProjectionMatrix.TransformPoint(vertex.position.ToVector4()) };
-			newPos.x /= newPos.w;
-			newPos.y /= newPos.w;
-			newPos.z /= newPos.w;
+		std::min<float>(v0.x, std::min(v1.x, v2.x)),
+		std::max<float>(v0.y, std::max(v1.y, v2.y))
+	};
 
-			//We calculate the transformed other elements of the mesh
-			const Vector3 newNormal{ mesh.worldMatrix.TransformVector(vertex.normal).Normalized()};
-			const Vector3 newTangent{ mesh.worldMatrix.TransformVector(vertex.tangent).Normalized()};
-			Vector3 newViewDirection{ newPos.GetXYZ() - m_Camera.origin};
-			newViewDirection.Normalize();
+	const Vector2 bottomRight
+	{
+		std::max<float>(v0.x, std::max(v1.x, v2.x)),
+		std::min<float>(v0.y, std::min(v1.y, v2.y))
+	};
 
-			//All the elements are added to the Vertices_Out vector
-			mesh.vertices_out.emplace_back(Vertex_Out{ newPos, vertex.color, vertex.uv, newNormal, newTangent, newViewDirection });
-		}
+	//Pixel bounding box, with one pixel margin, clamped to the screen
+	//The guard band keeps the coordinates small enough to be converted to int
+	triangle.minX = std::max(static_cast<int>(topLeft.x) - 1, 0);
+	triangle.maxX = std::min(static_cast<int>(bottomRight.x + 1), m_Width);
+	triangle.minY = std::max(static_cast<int>(bottomRight.y) - 1, 0);
+	triangle.maxY = std::min(static_cast<int>(topLeft.y + 1), m_Height);
+
+	//Outside of the screen or degenerated triangles don't cover any pixel
+	if (triangle.minX >= triangle.maxX || triangle.minY >= triangle.maxY || !SetupTriangle(triangle)) return false;
+
+	//The interpolated depth is a weighted harmonic mean of the vertex depths, so never below the smallest one
+	//The margin covers the rounding of the barycentric weights
+	triangle.minDepth = std::min(v0.z, std::min(v1.z, v2.z)) - m_DepthMargin;
+
+	const Vector4* positions[3]{ &triangle.v0, &triangle.v1, &triangle.v2 };
+	for (int i{ 0 }; i < 3; ++i)
+	{
+		const Vector2 uv{ triangle.pVertexStreams->GetUV(triangle.vertexIndices[i]) };
+		triangle.inverseW[i] = 1 / positions[i]->w;
+		triangle.uOverW[i] = uv.x * triangle.inverseW[i];
+		triangle.vOverW[i] = uv.y * triangle.inverseW[i];
 	}
+	return true;
 }
 
-void Renderer::ToggleDisplayZBuffer()
-{
-	//Invert displaying of ZBuffer
-	m_DisplayZBuffer = !m_DisplayZBuffer;
-}
-void Renderer::ToggleRotation()
-{
-	//Enable / Disable Rotation
-	m_IsRotationEnabled = !m_IsRotationEnabled;
-}
-void Renderer::ToggleNormalMap()
+void Renderer::FillTileTriangles(FrameData& frame) const
 {
-	//Display / Hide normal map
-	m_DisplayNormalMap = !m_DisplayNormalMap;
+	LinearArena& arena{ frame.arena.GetMainArena() };
+	const int nrTilesX{ (m_Width + m_TileSize - 1) / m_TileSize };
+	const auto forEachTile = [&frame, nrTilesX](const ScreenTriangle& triangle, const auto& function)
+		{
+			//Every tile the bounding box overlaps
+			for (int tileY{ triangle.minY / m_TileSize }; tileY <= (triangle.maxY - 1) / m_TileSize; ++tileY)
+			{
+				for (int tileX{ triangle.minX / m_TileSize }; tileX <= (triangle.maxX - 1) / m_TileSize; ++tileX)
+				{
+					function(frame.tiles[tileX + tileY * nrTilesX]);
+				}
+			}
+		};
+
+	//Count them first, so all the lists fit in one array
+	const std::span<uint32_t> nrTileTriangles{ arena.Allocate<uint32_t>(frame.tiles.size()) };
+	std::fill(nrTileTriangles.begin(), nrTileTriangles.end(), 0u);
+	const Tile* pFirstTile{ frame.tiles.data() };
+	for (const ScreenTriangle& triangle : frame.triangles)
+	{
+		forEachTile(triangle, [nrTileTriangles, pFirstTile](Tile& tile) { ++nrTileTriangles[&tile - pFirstTile]; });
+	}
+
+	size_t nrIndices{ 0 };
+	for (const uint32_t nrTriangles : nrTileTriangles)
+	{
+		nrIndices += nrTriangles;
+	}
+	const std::span<uint32_t> triangleIndices{ arena.Allocate<uint32_t>(nrIndices) };
+
+	size_t offset{ 0 };
+	for (size_t tileIndex{ 0 }; tileIndex < frame.tiles.size(); ++tileIndex)
+	{
+		frame.tiles[tileIndex].triangleIndices = triangleIndices.subspan(offset, nrTileTriangles[tileIndex]);
+		offset += nrTileTriangles[tileIndex];
+		nrTileTriangles[tileIndex] = 0;
+	}
+
+	//In submission order
+	for (size_t triangleIndex{ 0 }; triangleIndex < frame.triangles.size(); ++triangleIndex)
+	{
+		forEachTile(frame.triangles[triangleIndex], [nrTileTriangles, pFirstTile, triangleIndex](Tile& tile)
+			{
+				tile.triangleIndices[nrTileTriangles[&tile - pFirstTile]++] = static_cast<uint32_t>(triangleIndex);
+			});
+	}
 }
-void Renderer::CycleShadingMode()
+
+Renderer::TileFunction Renderer::GetTileFunction() const
 {
-	//Change Shading mode
+	//The shading mode, the normal map and the math mode don't change the depth view
+	if (m_DisplayZBuffer) return &Renderer::RenderTile<ShaderConfig<ShadingMode::ObservedArea, false, true, false>>;
 
+	const bool useNormalMap{ m_DisplayNormalMap && m_pMaterial->HasNormalMap() };
+	const bool useFastMath{ m_MathMode == MathMode::Fast };
 	switch (m_ShadingMode)
 	{
-	case ShadingMode::ObservedArea:
-		m_ShadingMode = ShadingMode::Diffuse;
-		break;
 	case ShadingMode::Diffuse:
-		m_ShadingMode = ShadingMode::Specular;
-		break;
+		return GetTileFunction<ShadingMode::Diffuse>(useNormalMap, useFastMath);
 	case ShadingMode::Specular:
-		m_ShadingMode = ShadingMode::Combined;
-		break;
+		return GetTileFunction<ShadingMode::Specular>(useNormalMap, useFastMath);
 	case ShadingMode::Combined:
-		m_ShadingMode = ShadingMode::ObservedArea;
-		break;
+		return GetTileFunction<ShadingMode::Combined>(useNormalMap, useFastMath);
+	default:
+		return GetTileFunction<ShadingMode::ObservedArea>(useNormalMap, useFastMath);
 	}
 }
-
-bool Renderer::SaveBufferToImage() const
+template<ShadingMode Mode>
+Renderer::TileFunction Renderer::GetTileFunction(const bool useNormalMap, const bool useFastMath) const
 {
-	return SDL_SaveBMP(m_pBackBuffer, "Rasterizer_ColorBuffer.bmp");
+	if (useFastMath)
+	{
+		if (useNormalMap) return &Renderer::RenderTile<ShaderConfig<Mode, true, false, true>>;
+		return &Renderer::RenderTile<ShaderConfig<Mode, false, false, true>>;
+	}
+
+	if (useNormalMap) return &Renderer::RenderTile<ShaderConfig<Mode, true, false, false>>;
+	return &Renderer::RenderTile<ShaderConfig<Mode, false, false, false>>;
 }
-bool Renderer::HitTest_Triangle(const Vector2& vertex0, const Vector2& vertex1, const Vector2& vertex2, const Vector2& pixel, Vector3& barycentricWeights) const
+
+template<typename Shader>
+void Renderer::RenderTile(Tile& tile)
 {
-	//Caculate vertices to pixel
-	const Vector2 v0{ vertex0, pixel };
-	const Vector2 v1{ vertex1, pixel };
-	const Vector2 v2{ vertex2, pixel };
+	TileStatistics& statistics{ tile.statistics };
+	statistics = TileStatistics{};
 
-	//Calculate edges
-	const Vector2 s0{ vertex0, vertex1 };
-	const Vector2 s1{ vertex1, vertex2 };
-	const Vector2 s2{ vertex2, vertex0 };
+	//Picked from the pixels of the last frame, before they are cleared
+	//The depth view shows the depth of every pixel, it is never coarse
+	tile.shadingRate = Shader::displayDepth ? 1 : GetTileShadingRate(tile);
+	tile.hasHistory = true;
 
-	//Parallelogram areas
-	const float c0{ Vector2::Cross(s1, v1) };
-	const float c1{ Vector2::Cross(s2, v2) };
-	const float c2{ Vector2::Cross(s0, v0) };
+	//The coarse shading is done when the visible triangle of every pixel is known
+	const bool useVisibilityBuffer{ m_UseVisibilityBuffer || tile.shadingRate > 1 };
 
-	//We check if all the parallelograms area ae poitning the same direction
-	if ((c1 >= 0 && c2 >= 0 && c0 >= 0) || (c1 <= 0 && c2 <= 0 && c0 <= 0))
-	{
-		//calculate triangle areas
-		const float triangleArea{ Vector2::Cross(s0, -s2) };
-		if (triangleArea == 0) return false;
+	const bool isProfiling{ m_Profiler.IsEnabled() };
+	const FrameProfiler::Clock::time_point clearStart{ isProfiling ? FrameProfiler::Clock::now() : FrameProfiler::Clock::time_point{} };
 
-		//Calculate barycentrics weights
-		barycentricWeights.x = c0 / triangleArea;
-		barycentricWeights.y = c1 / triangleArea;
-		barycentricWeights.z = c2 / triangleArea;
-		return true;
+	//Reinit buffer values of the tile
+	const int tileWidth{ tile.maxX - tile.minX };
+	for (int py{ tile.minY }; py < tile.maxY; ++py)
+	{
+		std::fill_n(m_pDepthBufferPixels + tile.minX + py * m_BufferWidth, tileWidth, FLT_MAX);
+		std::fill_n(m_pBackBufferPixels + tile.minX + py * m_BufferWidth, tileWidth, m_ClearColor);
+		if (useVisibilityBuffer) std::fill_n(m_pVisibilityBufferPixels + tile.minX + py * m_BufferWidth, tileWidth, m_NoTriangle);
 	}
-	return false;
-}
+	std::fill_n(tile.depthBlockMax, Tile::maxNrDepthBlocks, FLT_MAX);
+	tile.dirtyDepthBlocks = 0;
 
-void Renderer::RenderAPixel(const int px, const int py, const Vector4& v0, const Vector4& v1, const Vector4& v2, const Mesh& mesh, const int index)
-{
-	const int pixelNr{ px + (m_Width * py) };
-	const Vector2 pixel
+	const FrameProfiler::Clock::time_point rasterizationStart{ isProfiling ? FrameProfiler::Clock::now() : FrameProfiler::Clock::time_point{} };
+
+	//Nullptr when the scalar reference path is selected
+	const PixelKernel::BlockFunction blockFunction{ PixelKernel::GetBlockFunction(m_PixelKernel) };
+
+	for (const uint32_t triangleIndex : tile.triangleIndices)
 	{
-		px + 0.5f,
-		py + 0.5f
-	};
+		const ScreenTriangle& triangle{ m_pRasterizedFrame->triangles[triangleIndex] };
 
-	ColorRGB finalColor{};
-	Vector3 barycentrics{};
-
-	//Check if the pixel hits a number + attribute the barycentric weights
-	if (HitTest_Triangle({ v0.x, v0.y }, { v1.x, v1.y }, { v2.x, v2.y }, pixel, barycentrics))
-	{
-
-		//Corrected Depth interpolation
-		const float z0{ barycentrics.x / v0.z };
-		const float z1{ barycentrics.y / v1.z };
-		const float z2{ barycentrics.z / v2.z };
-
-		float zBufferValue{ 1 / (z0 + z1 + z2) };
-
-		//Check if we can use this buffer value
-		if (zBufferValue < 0 || zBufferValue > 1 || zBufferValue >= m_pDepthBufferPixels[pixelNr]) return;
-
-		//W value
-		const float w0{ barycentrics.x / v0.w };
-		const float w1{ barycentrics.y / v1.w };
-		const float w2{ barycentrics.z / v2.w };
-		const float wInterpolated{ 1 / (w0 + w1 + w2) };
-
-		//interpolated UV
-		const Vector2 uv0{ barycentrics.x * (mesh.vertices_out[mesh.indices[index]].uv / v0.w) };
-		const Vector2 uv1{ barycentrics.y * (mesh.vertices_out[mesh.indices[index + 1]].uv / v1.w) };
-		const Vector2 uv2{ barycentrics.z * (mesh.vertices_out[mesh.indices[index + 2]].uv / v2.w) };
-		const Vector2 interpolatedUV{ (uv0 + uv1 + uv2) * wInterpolated };
-
-		//If uv value outside of the uv map, we display nothing
-		if (interpolatedUV.x < 0 || interpolatedUV.x > 1 || interpolatedUV.y < 0 || interpolatedUV.y > 1) return;
-
-		//takes really long
-		m_pDepthBufferPixels[pixelNr] = zBufferValue;
-
-		if (!m_DisplayZBuffer)
-		{
-			//calculate interpolated normal
-			const Vector3 n0{ barycentrics.x * (mesh.vertices_out[mesh.indices[index]].normal) };
-			const Vector3 n1{ barycentrics.y * (mesh.vertices_out[mesh.indices[index + 1]].normal) };
-			const Vector3 n2{ barycentrics.z * (mesh.vertices_out[mesh.indices[index + 2]].normal) };
-			const Vector3 interpolatedNormal{ (n0 + n1 + n2).Normalized() };
-
-			//calculate interpolated tangent
-			const Vector3 t0{ barycentrics.x * (mesh.vertices_out[mesh.indices[index]].tangent) };
-			const Vector3 t1{ barycentrics.y * (mesh.vertices_out[mesh.indices[index + 1]].tangent) };
-			const Vector3 t2{ barycentrics.z * (mesh.vertices_out[mesh.indices[index + 2]].tangent) };
-			const Vector3 interpolatedTangent{ (t0 + t1 + t2).Normalized() };
-
-			//calculate interpolated viewDirection
-			const Vector3 view0{ barycentrics.x * (mesh.vertices_out[mesh.indices[index]].viewDirection) };
-			const Vector3 view1{ barycentrics.y * (mesh.vertices_out[mesh.indices[index + 1]].viewDirection) };
-			const Vector3 view2{ barycentrics.z * (mesh.vertices_out[mesh.indices[index + 2]].viewDirection) };
-			const Vector3 interpolatedViewDirection{ (view0 + view1 + view2).Normalized() };
-			
-			//Get the color value from the texture map
-			finalColor = m_pTexture->Sample(interpolatedUV);
-			
-			//Create a new vertex out with all the interpolated value
-			Vertex_Out interpolatedVertex
-			{
-				Vector4{v0.x, v0.y, zBufferValue, wInterpolated},
-				finalColor,
-				interpolatedUV,
-				interpolatedNormal,
-				interpolatedTangent,
-				interpolatedViewDirection
-			};
+		//Only walk the part of the bounding box inside of the tile
+		const int minX{ std::max(triangle.minX, tile.minX) };
+		const int maxX{ std::min(triangle.maxX, tile.maxX) };
+		const int minY{ std::max(triangle.minY, tile.minY) };
+		const int maxY{ std::min(triangle.maxY, tile.maxY) };
+
+		//Hidden behind what was already drawn, none of the pixels would pass the depth test
+		const uint32_t depthBlockMask{ GetDepthBlockMask(tile, minX, minY, maxX, maxY) };
+		if (m_UseHierarchicalDepth && IsOccluded(tile, triangle, depthBlockMask))
+		{
+			++statistics.counters.trianglesOccluded;
+			continue;
+		}
+		tile.dirtyDepthBlocks |= depthBlockMask;
 
-			//Shade the pixel
-			finalColor = PixelShading(interpolatedVertex);
+		//The visibility buffer only writes depth and triangle here, whatever the shading options
+		if (useVisibilityBuffer)
+		{
+			if (blockFunction) RasterizeTriangleBlocks<VisibilityPassConfig>(triangle, minX, minY, maxX, maxY, blockFunction, statistics);
+			else RasterizeTriangleScalar<VisibilityPassConfig>(triangle, minX, minY, maxX, maxY, statistics);
+		}
+		else if (blockFunction)
+		{
+			RasterizeTriangleBlocks<Shader>(triangle, minX, minY, maxX, maxY, blockFunction, statistics);
 		}
 		else
 		{
-			//Display Z buffer values
-			const float mappedValue{ Remap(zBufferValue,0.985f, 1.0f) };
-			finalColor = ColorRGB{ mappedValue,mappedValue,mappedValue };
-		}	
+			RasterizeTriangleScalar<Shader>(triangle, minX, minY, maxX, maxY, statistics);
+		}
+	}
 
-		//Update Color in Buffer
-		finalColor.MaxToOne();
+	//Every visible pixel is shaded once, hidden surfaces never reach the shading
+	if (tile.shadingRate > 1)
+	{
+		ShadeVisibilityBufferCoarse<Shader>(tile, tile.shadingRate, statistics);
+	}
+	else if (useVisibilityBuffer)
+	{
+		ShadeVisibilityBuffer<Shader>(tile, blockFunction, statistics);
+	}
 
-		m_pBackBufferPixels[pixelNr] = SDL_MapRGB(m_pBackBuffer->format,
-			static_cast<uint8_t>(finalColor.r * 255),
-			static_cast<uint8_t>(finalColor.g * 255),
-			static_cast<uint8_t>(finalColor.b * 255));
+	if (isProfiling)
+	{
+		//The shading was timed pixel per pixel inside of the rasterization
+		statistics.clearMs = FrameProfiler::ToMilliseconds(rasterizationStart - clearStart);
+		statistics.rasterizationMs = FrameProfiler::ToMilliseconds(FrameProfiler::Clock::now() - rasterizationStart) - statistics.shadingMs;
 	}
 }
-void Renderer::RenderMeshes(std::vector<Mesh>& meshesWorld)
+
+int Renderer::GetTileShadingRate(const Tile& tile) const
 {
-	//Reinit buffer values
-	std::fill_n(m_pDepthBufferPixels, m_Width * m_Height, FLT_MAX);
-	std::fill_n(m_pBackBufferPixels, m_Width * m_Height, SDL_MapRGB(m_pBackBuffer->format,
-		static_cast<uint8_t>(m_AmbiantColor.r * 255),
-		static_cast<uint8_t>(m_AmbiantColor.g * 255),
-		static_cast<uint8_t>(m_AmbiantColor.b * 255)));
+	switch (m_pRasterizedFrame->useFullShadingRate ? ShadingRate::Full : m_ShadingRate)
+	{
+	case ShadingRate::Coarse2x2:
+		return 2;
+	case ShadingRate::Coarse4x4:
+		return 4;
+	case ShadingRate::Adaptive:
+	{
+		//Both frame data have the same tiles, InitTiles changes them together
+		const Tile& historyTile{ m_pHistoryFrame->tiles[&tile - m_pRasterizedFrame->tiles.data()] };
 
-	//slows a lot (find a faster way ?)
-	VertexTransformationFunction(meshesWorld);
+		//Nothing to measure yet, start with every detail
+		if (!historyTile.hasHistory) return 1;
 
-	for (const Mesh& mesh : meshesWorld)
+		const float contrast{ GetTileContrast(historyTile) };
+		if (contrast < m_MaxContrast4x4) return 4;
+		if (contrast < m_MaxContrast2x2) return 2;
+		return 1;
+	}
+	default:
+		return 1;
+	}
+}
+float Renderer::GetTileContrast(const Tile& tile) const
+{
+	//Rasterizing this frame doesn't write to it when pipelined, the render thread only presents it meanwhile
+	const SDL_Surface* pHistory{ m_pHistoryFrame->pBackBuffer };
+	const uint32_t* pHistoryPixels{ (const uint32_t*)pHistory->pixels };
+	const auto getLuminance = [this, pHistory, pHistoryPixels](const int px, const int py)
+		{
+			uint8_t r{}, g{}, b{};
+			SDL_GetRGB(pHistoryPixels[px + py * m_BufferWidth], pHistory->format, &r, &g, &b);
+			return 0.2126f * r + 0.7152f * g + 0.0722f * b;
+		};
+
+	//Mean difference with the right and the bottom neighbour on a grid of the largest block
+	float sumDifferences{ 0.0f };
+	int nrDifferences{ 0 };
+	for (int py{ tile.minY }; py < tile.maxY; py += m_ContrastSampleSpacing)
 	{
-		//Convert vertices to ScreenSpace
-		std::vector<Vector2> vetrices_screenSpace{};
-		for (const Vertex_Out& v : mesh.vertices_out)
+		for (int px{ tile.minX }; px < tile.maxX; px += m_ContrastSampleSpacing)
 		{
-			vetrices_screenSpace.push_back(ToScreenSpace(v.position.x, v.position.y));
+			const float luminance{ getLuminance(px, py) };
+			if (px + m_ContrastSampleSpacing < tile.maxX)
+			{
+				sumDifferences += std::abs(getLuminance(px + m_ContrastSampleSpacing, py) - luminance);
+				++nrDifferences;
+			}
+			if (py + m_ContrastSampleSpacing < tile.maxY)
+			{
+				sumDifferences += std::abs(getLuminance(px, py + m_ContrastSampleSpacing) - luminance);
+				++nrDifferences;
+			}
 		}
+	}
+	return nrDifferences ? sumDifferences / nrDifferences : 0.0f;
+}
 
+uint32_t Renderer::GetDepthBlockMask(const Tile& tile, const int minX, const int minY, const int maxX, const int maxY) const
+{
+	const int firstBlockX{ (minX - tile.minX) / Tile::depthBlockSize };
+	const int lastBlockX{ (maxX - 1 - tile.minX) / Tile::depthBlockSize };
+	const int firstBlockY{ (minY - tile.minY) / Tile::depthBlockSize };
+	const int lastBlockY{ (maxY - 1 - tile.minY) / Tile::depthBlockSize };
+
+	const uint32_t rowMask{ ((1u << (lastBlockX - firstBlockX + 1)) - 1) << firstBlockX };
+	uint32_t mask{};
+	for (int blockY{ firstBlockY }; blockY <= lastBlockY; ++blockY)
+	{
+		mask |= rowMask << (blockY * m_NrDepthBlocksX);
+	}
+	return mask;
+}
+bool Renderer::IsOccluded(Tile& tile, const ScreenTriangle& triangle, const uint32_t depthBlockMask) const
+{
+	//Only the written blocks the triangle overlaps are calculated again, the others keep their upper bound
+	for (uint32_t dirtyMask{ tile.dirtyDepthBlocks & depthBlockMask }; dirtyMask; dirtyMask &= dirtyMask - 1)
+	{
+		const int block{ std::countr_zero(dirtyMask) };
+		const int minX{ tile.minX + (block % m_NrDepthBlocksX) * Tile::depthBlockSize };
+		const int minY{ tile.minY + (block / m_NrDepthBlocksX) * Tile::depthBlockSize };
+		const int maxX{ std::min(minX + Tile::depthBlockSize, tile.maxX) };
+		const int maxY{ std::min(minY + Tile::depthBlockSize, tile.maxY) };
+
+		float maxDepth{ 0.0f };
+		for (int py{ minY }; py < maxY; ++py)
+		{
+			const float* pDepth{ m_pDepthBufferPixels + py * m_BufferWidth };
+			for (int px{ minX }; px < maxX; ++px)
+			{
+				maxDepth = pDepth[px] > maxDepth ? pDepth[px] : maxDepth;
+			}
+		}
+		tile.depthBlockMax[block] = maxDepth;
+	}
+	tile.dirtyDepthBlocks &= ~depthBlockMask;
 
-		//Determine how we will iterate through the for loop dending of the mesh topology
-		int incrementIndex{ 1 };
-		size_t maxSize{ mesh.indices.size() };
+	for (uint32_t blockMask{ depthBlockMask }; blockMask; blockMask &= blockMask - 1)
+	{
+		if (triangle.minDepth < tile.depthBlockMax[std::countr_zero(blockMask)]) return false;
+	}
+	return true;
+}
 
-		switch (mesh.primitiveTopology)
+template<typename Shader>
+void Renderer::RasterizeTriangleScalar(const ScreenTriangle& triangle, const int minX, const int minY, const int maxX, const int maxY, TileStatistics& statistics)
+{
+	//RENDER LOGIC
+	for (int py{ minY }; py < maxY; ++py)
+	{
+		//Only the pixels inside of the triangle are visited
+		int begin{};
+		int end{};
+		if (!GetCoveredSpan(triangle, py, minX, maxX, begin, end)) continue;
+
+		//Step from the start of the span, exactly like the block kernels
+		const Vector3 rowWeights{ GetEdgeWeights(triangle, begin, py) };
+		for (int px{ begin }; px < end; ++px)
 		{
-		case PrimitiveTopology::TriangleList:
-			incrementIndex = 3;
-			break;
-		case PrimitiveTopology::TriangleStrip:
-			maxSize -= 2;
-			break;
+			const Vector3 weights{ rowWeights + triangle.edgeStepXFloat * static_cast<float>(px - begin) };
+			RenderAPixel<Shader>(px, py, triangle, weights * triangle.inverseArea, statistics);
+		}
+	}
+}
+
+template<typename Shader>
+void Renderer::ShadeBlockLane(const ScreenTriangle& triangle, const PixelBlock& block, const int lane, const int px, const int py)
+{
+	Vertex_Out interpolatedVertex
+	{
+		Vector4{triangle.v0.x, triangle.v0.y, block.depth[lane], block.w[lane]},
+		ColorRGB{},
+		Vector2{ block.u[lane], block.v[lane] }
+	};
+
+	if constexpr (!Shader::displayDepth)
+	{
+		interpolatedVertex.normal = Vector3{ block.normalX[lane], block.normalY[lane], block.normalZ[lane] };
+		interpolatedVertex.tangent = Vector3{ block.tangentX[lane], block.tangentY[lane], block.tangentZ[lane] };
+		interpolatedVertex.viewDirection = Vector3{ block.viewX[lane], block.viewY[lane], block.viewZ[lane] };
+	}
+
+	ShadePixel<Shader>(px + lane + (m_BufferWidth * py), interpolatedVertex, GetTextureGradient<Shader>(triangle, px + lane, py));
+}
+KernelTriangle Renderer::GetKernelTriangle(const ScreenTriangle& triangle, const bool useFastMath) const
+{
+	const Vector4* positions[3]{ &triangle.v0, &triangle.v1, &triangle.v2 };
+
+	//Gather the vertex attributes once for all the pixels of the triangle
+	KernelTriangle kernelTriangle{};
+	kernelTriangle.edgeStepX = triangle.edgeStepXFloat;
+	kernelTriangle.inverseArea = triangle.inverseArea;
+	for (int i{ 0 }; i < 3; ++i)
+	{
+		const VertexOutputStreams& streams{ *triangle.pVertexStreams };
+		const uint32_t vertexIndex{ triangle.vertexIndices[i] };
+		kernelTriangle.z[i] = positions[i]->z;
+		kernelTriangle.w[i] = positions[i]->w;
+		if (useFastMath)
+		{
+			kernelTriangle.inverseW[i] = FastMath::Reciprocal(positions[i]->w);
+			kernelTriangle.uvOverW[i] = streams.GetUV(vertexIndex) * kernelTriangle.inverseW[i];
+		}
+		else
+		{
+			kernelTriangle.uvOverW[i] = streams.GetUV(vertexIndex) / positions[i]->w;
 		}
+		kernelTriangle.normal[i] = streams.GetNormal(vertexIndex);
+		kernelTriangle.tangent[i] = streams.GetTangent(vertexIndex);
+		kernelTriangle.viewDirection[i] = streams.GetViewDirection(vertexIndex);
+	}
+
+	return kernelTriangle;
+}
+template<typename Shader>
+void Renderer::RasterizeTriangleBlocks(const ScreenTriangle& triangle, const int minX, const int minY, const int maxX, const int maxY, PixelKernel::BlockFunction blockFunction, TileStatistics& statistics)
+{
+	const KernelTriangle kernelTriangle{ GetKernelTriangle(triangle, Shader::useFastMath) };
+
+	constexpr bool interpolateShading{ !Shader::displayDepth && !Shader::visibilityOnly };
+	const bool isProfiling{ m_Profiler.IsEnabled() };
+	PixelBlock block{};
+
+	for (int py{ minY }; py < maxY; ++py)
+	{
+		int begin{};
+		int end{};
+		if (!GetCoveredSpan(triangle, py, minX, maxX, begin, end)) continue;
 
-		for (int index{ 0 }; index < maxSize; index += incrementIndex)
+		const Vector3 rowWeights{ GetEdgeWeights(triangle, begin, py) };
+		for (int px{ begin }; px < end; px += PixelBlock::size)
 		{
-			//Calculate the value of the three vetrices
-			const Vector4 v0
-			{
-				vetrices_screenSpace[mesh.indices[index]].x,
-				vetrices_screenSpace[mesh.indices[index]].y,
-				mesh.vertices_out[mesh.indices[index]].position.z,
-				mesh.vertices_out[mesh.indices[index]].position.w
-			};
+			const int count{ std::min(PixelBlock::size, end - px) };
+			blockFunction(kernelTriangle, rowWeights, static_cast<float>(px - begin), m_pDepthBufferPixels + px + py * m_BufferWidth, count, interpolateShading, Shader::useFastMath, block);
 
-			const Vector4 v1
-			{
-				vetrices_screenSpace[mesh.indices[index + 1]].x,
-				vetrices_screenSpace[mesh.indices[index + 1]].y,
-				mesh.vertices_out[mesh.indices[index + 1]].position.z,
-				mesh.vertices_out[mesh.indices[index + 1]].position.w
-			};
+			uint32_t visibleMask{ block.visibleMask };
+			statistics.counters.pixelsTested += count;
+			statistics.counters.pixelsDepthPassed += std::popcount(block.depthPassMask);
+			if constexpr (!Shader::visibilityOnly) statistics.counters.pixelsShaded += std::popcount(visibleMask);
 
-			const Vector4 v2
-			{
-				vetrices_screenSpace[mesh.indices[index + 2]].x,
-				vetrices_screenSpace[mesh.indices[index + 2]].y,
-				mesh.vertices_out[mesh.indices[index + 2]].position.z,
-				mesh.vertices_out[mesh.indices[index + 2]].position.w
-			};
-
-			//Define triangle bounding box
-			Vector2 topLeft
+			const FrameProfiler::Clock::time_point shadingStart{ isProfiling ? FrameProfiler::Clock::now() : FrameProfiler::Clock::time_point{} };
+			while (visibleMask)
 			{
-				std::min<float>(v0.x, std::min(v1.x, v2.x)),
-				std::max<float>(v0.y, std::max(v1.y, v2.y))
-			};
-			
-			Vector2 bottomRight
-			{
-				std::max<float>(v0.x, std::max(v1.x, v2.x)),
-				std::min<float>(v0.y, std::min(v1.y, v2.y))
-			};
+				const int lane{ std::countr_zero(visibleMask) };
+				visibleMask &= visibleMask - 1;
 
-			//If bounding box outise of the screen --> we don't display the triangle
-			if ((topLeft.x <= 0 || bottomRight.x > m_Width) || (bottomRight.y <= 0 || topLeft.y > m_Height)) continue;
+				const int pixelNr{ px + lane + (m_BufferWidth * py) };
+				m_pDepthBufferPixels[pixelNr] = block.depth[lane];
 
-			//RENDER LOGIC
-			for (int px{ static_cast<int>(topLeft.x) - 1 }; px < static_cast<int>(bottomRight.x + 1); ++px)
-			{
-				for (int py{ static_cast<int>(bottomRight.y) - 1 }; py < static_cast<int>(topLeft.y + 1); ++py)
+				if constexpr (Shader::visibilityOnly)
+				{
+					m_pVisibilityBufferPixels[pixelNr] = static_cast<uint32_t>(&triangle - m_pRasterizedFrame->triangles.data());
+				}
+				else
 				{
-					RenderAPixel(px, py, v0, v1, v2, mesh, index);
+					ShadeBlockLane<Shader>(triangle, block, lane, px, py);
 				}
 			}
+			if (isProfiling) statistics.shadingMs += FrameProfiler::ToMilliseconds(FrameProfiler::Clock::now() - shadingStart);
 		}
 	}
 }
@@ -381,6 +2263,12 @@ Vector2 Renderer::ToScreenSpace(const float x, const float y) const
 
 	return{ newX, newY };
 }
+Vector4 Renderer::ToScreenPosition(const Vector4& clipPos) const
+{
+	//Perspective division
+	const Vector2 screenPos{ ToScreenSpace(clipPos.x / clipPos.w, clipPos.y / clipPos.w) };
+	return { screenPos.x, screenPos.y, clipPos.z / clipPos.w, clipPos.w };
+}
 float Renderer::Remap(const float value, const float min, const float max) const
 {
 	if (max <= min || value > max || value < min) return 0;
@@ -394,102 +2282,112 @@ float Renderer::Remap(const float value, const float min, const float max) const
 
 }
 
-ColorRGB Renderer::PixelShading(const Vertex_Out& vOut) const
+template<typename Shader>
+TextureGradient Renderer::GetTextureGradient(const ScreenTriangle& triangle, const int px, const int py) const
 {
-	const Vector3 lightDirection{ 0.577f, -0.577f, 0.577f };
+	if constexpr (!Shader::needsMaterial) return {};
+	if (m_TextureFilter == TextureFilter::Point) return {};
+
+	//All the pixels of a 2x2 quad use the same gradient, like on the gpu
+	//The edge functions are linear, so they can also be evaluated outside of the triangle
+	const Vector3 weights{ GetEdgeWeights(triangle, px & ~1, py & ~1) };
+
+	const auto interpolateUV = [&triangle](const Vector3& edgeValues) -> Vector2
+		{
+			const float inverseW{ 1 / Vector3::Dot(edgeValues, triangle.inverseW) };
+			return { Vector3::Dot(edgeValues, triangle.uOverW) * inverseW, Vector3::Dot(edgeValues, triangle.vOverW) * inverseW };
+		};
+
+	const Vector2 uv{ interpolateUV(weights) };
+	return { interpolateUV(weights + triangle.edgeStepXFloat) - uv, interpolateUV(weights + triangle.edgeStepYFloat) - uv };
+}
+MaterialSample Renderer::SampleMaterial(const Vector2& uv, const TextureGradient& gradient) const
+{
+	if (m_TextureFilter == TextureFilter::Point) return m_pMaterial->Sample(uv);
 
-	//Tangent space axis
-	const Vector3 binormal = Vector3::Cross(vOut.normal, vOut.tangent);
-	const Matrix tangentSpaceAxis{ vOut.tangent, binormal, vOut.normal, Vector4{0,0,0,0} };
+	return m_pMaterial->Sample(uv, gradient);
+}
 
-	//sample the normal from normal map and place in interval [-1;1]
-	ColorRGB sampledNormal = m_pNormalMap->Sample(vOut.uv);
-	sampledNormal *= 2.0f;
-	sampledNormal.r -= 1.0f;
-	sampledNormal.g -= 1.0f;
-	sampledNormal.b -= 1.0f;
+template<typename Shader>
+ColorRGB Renderer::PixelShading(const Vertex_Out& vOut, const MaterialSample& material) const
+{
+	const Vector3 lightDirection{ 0.577f, -0.577f, 0.577f };
 
-	//Final normal value depends of the input of the player
-	const Vector3 finalNormal = m_DisplayNormalMap?
-								tangentSpaceAxis.TransformVector({ sampledNormal.r, sampledNormal.g, sampledNormal.b })
-								:
-								vOut.normal;
+	//Final normal value depends of the input of the player, the material already placed it in interval [-1;1]
+	Vector3 finalNormal{ vOut.normal };
+	if constexpr (Shader::useNormalMap)
+	{
+		//Tangent space axis
+		const Vector3 binormal = Vector3::Cross(vOut.normal, vOut.tangent);
+		const Matrix tangentSpaceAxis{ vOut.tangent, binormal, vOut.normal, Vector4{0,0,0,0} };
+		finalNormal = tangentSpaceAxis.TransformVector(material.normal);
+	}
 
 	//OA
 	// **************
 	const float observedArea{ Vector3::Dot(-lightDirection, finalNormal) };
+	if (observedArea <= 0) return{ 0,0,0 };
+
+	if constexpr (Shader::shadingMode == ShadingMode::ObservedArea)
+	{
+		return{ observedArea, observedArea, observedArea };
+	}
 
 	//Diffuse
 	// **************
-	const float kd{ 2.0f };
-	const ColorRGB diffuseColor{ vOut.color * kd  };
+	ColorRGB diffuseColor{};
+	if constexpr (Shader::needsDiffuse)
+	{
+		const float kd{ 2.0f };
+		diffuseColor = vOut.color * kd;
+	}
 
 	//Phong
 	// **************
-	//calculate glossy
-	ColorRGB glossyValue = m_pGlossyMap->Sample(vOut.uv);
-	const float glossiness{ 25.0f };
-	glossyValue *= glossiness;
-
-	//calculate specular
-	ColorRGB specularValue = m_pSpecularMap->Sample(vOut.uv);
+	ColorRGB specularReflection{};
+	if constexpr (Shader::needsSpecular)
+	{
+		//calculate glossy, meshes without gloss or specular map have no specular reflection
+		const float glossiness{ 25.0f };
+		const float glossyValue{ material.gloss * glossiness };
 
-	const Vector3 reflect{ Vector3::Reflect(-lightDirection, finalNormal)};
+		//calculate specular
+		const ColorRGB& specularValue{ material.specular };
 
-	//If cosinue is lower than zero we take a 0 value
-	float cosinus{ std::max(0.0f,Vector3::Dot(reflect, vOut.viewDirection)) };
+		const Vector3 reflect{ Vector3::Reflect(-lightDirection, finalNormal)};
 
-	ColorRGB specularReflection
-	{ 
-		specularValue.r * powf(cosinus, glossyValue.r),
-		specularValue.g * powf(cosinus, glossyValue.r),
-		specularValue.b * powf(cosinus, glossyValue.r)
-	};
+		//If cosinue is lower than zero we take a 0 value
+		const float cosinus{ std::max(0.0f,Vector3::Dot(reflect, vOut.viewDirection)) };
+		float phong{};
+		if constexpr (Shader::useFastMath) phong = FastMath::Pow(cosinus, glossyValue);
+		else phong = powf(cosinus, glossyValue);
 
-	//avoid negative value for specular reflection
-	specularReflection.r = std::max(0.0f, specularReflection.r);
-	specularReflection.g = std::max(0.0f, specularReflection.g);
-	specularReflection.b = std::max(0.0f, specularReflection.b);
+		//avoid negative value for specular reflection
+		specularReflection.r = std::max(0.0f, specularValue.r * phong);
+		specularReflection.g = std::max(0.0f, specularValue.g * phong);
+		specularReflection.b = std::max(0.0f, specularValue.b * phong);
+	}
 
-	if (observedArea > 0)
+	if constexpr (Shader::shadingMode == ShadingMode::Diffuse)
 	{
-		switch (m_ShadingMode)
-		{
-		case ShadingMode::ObservedArea:
-			return{ observedArea, observedArea, observedArea };
-			break;
-			
-		case ShadingMode::Diffuse:
-			return diffuseColor * observedArea;
-			break;
-
-		case ShadingMode::Specular:
-			return specularReflection * observedArea;
-			break;
-
-		case ShadingMode::Combined:
-			const ColorRGB diffuseSpecularColor{ diffuseColor + specularReflection };
-			return diffuseSpecularColor * observedArea;
-			break;
-		}
+		return diffuseColor * observedArea;
+	}
+	else if constexpr (Shader::shadingMode == ShadingMode::Specular)
+	{
+		return specularReflection * observedArea;
+	}
+	else
+	{
+		const ColorRGB diffuseSpecularColor{ diffuseColor + specularReflection };
+		return diffuseSpecularColor * observedArea;
 	}
-
-	return{ 0,0,0 };
 }
 
 void Renderer::Render_W4_Part1()
 {
-	//Define Triangle List
-	//InitMeshes
-
-	m_MeshesWorld.clear();
-
-	//Find a more optimal solution ?
-	m_MeshesWorld = m_NonTransformedMeshes;
+	//Only the transform of the instance changes, the mesh data is shared and never copied
 	const Matrix meshTransformation{ Matrix::CreateRotationY(m_MeshRotationAngle) * Matrix::CreateTranslation(m_MeshPosition) };
+	m_Scene.SetInstanceTransform(m_VehicleInstance, meshTransformation);
 
-
-	m_MeshesWorld[0].worldMatrix = meshTransformation;
-
-	RenderMeshes(m_MeshesWorld);
+	RenderMeshes(m_Scene);
 }
\ No newline at end of file
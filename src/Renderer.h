@@ -1,19 +1,31 @@
 #pragma once
 
+#include <condition_variable>
 #include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <span>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "Camera.h"
 #include "DataTypes.h"
+#include "FastMath.h"
+#include "FrameArena.h"
+#include "FrameProfiler.h"
+#include "Material.h"
+#include "PixelKernel.h"
+#include "Scene.h"
+#include "VertexKernel.h"
 
 struct SDL_Window;
 struct SDL_Surface;
+struct SDL_PixelFormat;
 
 
 namespace dae
 {
-	class Texture;
-	struct Mesh;
 	struct Vertex;
 	class Timer;
 	class Scene;
@@ -28,10 +40,247 @@ namespace dae
 		Combined
 	};
 
+	//Lighting evaluated once per block of pixels and copied to the others, the depth and the coverage stay per pixel
+	enum struct ShadingRate
+	{
+		Full,
+		Coarse2x2,
+		Coarse4x4,
+		Adaptive //Picked per tile from the contrast of its last frame
+	};
+
+	//Shading options of a frame, fixed at compile time in the raster and shading loops
+	//so every combination only does the work it needs
+	template<ShadingMode Mode, bool UseNormalMap, bool DisplayDepth, bool UseFastMath>
+	struct ShaderConfig
+	{
+		static constexpr ShadingMode shadingMode{ Mode };
+		static constexpr bool displayDepth{ DisplayDepth };
+		static constexpr bool useNormalMap{ UseNormalMap && !DisplayDepth };
+		static constexpr bool useFastMath{ UseFastMath && !DisplayDepth }; //See MathMode
+
+		static constexpr bool needsDiffuse{ !DisplayDepth && (Mode == ShadingMode::Diffuse || Mode == ShadingMode::Combined) };
+		static constexpr bool needsSpecular{ !DisplayDepth && (Mode == ShadingMode::Specular || Mode == ShadingMode::Combined) };
+		static constexpr bool needsMaterial{ needsDiffuse || needsSpecular || useNormalMap };
+		static constexpr bool needsTangent{ useNormalMap };
+		static constexpr bool needsViewDirection{ needsSpecular };
+
+		static constexpr bool visibilityOnly{ false };
+	};
+
+	//First pass of the visibility buffer, only the depth and the closest triangle of every pixel are written
+	struct VisibilityPassConfig
+	{
+		static constexpr ShadingMode shadingMode{ ShadingMode::ObservedArea };
+		static constexpr bool displayDepth{ false };
+		static constexpr bool useNormalMap{ false };
+		static constexpr bool useFastMath{ false };
+
+		static constexpr bool needsDiffuse{ false };
+		static constexpr bool needsSpecular{ false };
+		static constexpr bool needsMaterial{ false };
+		static constexpr bool needsTangent{ false };
+		static constexpr bool needsViewDirection{ false };
+
+		static constexpr bool visibilityOnly{ true };
+	};
+
+	//Files loaded by the renderer, empty texture paths are skipped
+	struct RenderAssets
+	{
+		std::string meshPath{ "Resources/vehicle.obj" };
+		std::string diffusePath{ "Resources/vehicle_diffuse.png" };
+		std::string normalPath{ "Resources/vehicle_normal.png" };
+		std::string glossPath{ "Resources/vehicle_gloss.png" };
+		std::string specularPath{ "Resources/vehicle_specular.png" };
+	};
+
+	//Work and time of one tile during a frame, summed once all the workers are done
+	struct TileStatistics
+	{
+		double clearMs{};
+		double rasterizationMs{};
+		double shadingMs{};
+		FrameCounters counters{};
+	};
+
+	//Pixel rectangle, max values excluded, empty when min >= max
+	struct ScreenRect
+	{
+		int minX{};
+		int minY{};
+		int maxX{};
+		int maxY{};
+
+		bool IsEmpty() const;
+		bool Overlaps(const ScreenRect& other) const;
+		void Add(const ScreenRect& other);
+	};
+
+	//Everything a frame depends on besides the instance transforms
+	//While it doesn't change the previous frame is reused, only the tiles the moved instances cover are rendered again
+	struct FrameStateKey
+	{
+		Matrix viewMatrix{};
+		Matrix projectionMatrix{};
+		int width{};
+		int height{};
+		bool displayZBuffer{};
+		bool displayNormalMap{};
+		ShadingMode shadingMode{};
+		PixelKernelType pixelKernel{};
+		TextureFilter textureFilter{};
+		bool useVisibilityBuffer{};
+		bool isBackFaceCullingEnabled{};
+		bool useHierarchicalDepth{};
+		ShadingRate shadingRate{};
+		bool useLevelOfDetail{};
+		VertexFormat vertexFormat{};
+		MathMode mathMode{};
+
+		bool operator==(const FrameStateKey& other) const;
+	};
+
+	//An instance in the last rendered frame
+	struct InstanceFrameState
+	{
+		Matrix worldMatrix{};
+		ScreenRect bounds{}; //Bounding boxes of its rasterized triangles
+		ScreenRect previousBounds{}; //Pixels it covered in the frame before, they have to be rendered again when it moves
+		bool isMoved{}; //Since the last rendered frame, always set when the whole frame is rendered
+		uint32_t version{}; //Changes every time it moves, see InstanceVertices
+	};
+
+	//Part of the vertices of an instance, transformed by one worker
+	struct VertexChunk
+	{
+		const MeshInstance* pInstance{};
+		VertexOutputStreams* pOutput{}; //Of the prepared frame
+		const VertexKernel::TransformConstants* pConstants{};
+		size_t first{};
+		size_t count{};
+	};
+
+	//Triangle after vertex transformation, ready to be rasterized by the tiles it overlaps
+	struct ScreenTriangle
+	{
+		//Screen space x and y, projected z and w
+		Vector4 v0{};
+		Vector4 v1{};
+		Vector4 v2{};
+
+		//Output of the vertex stage, or new vertices when the triangle was clipped
+		const VertexOutputStreams* pVertexStreams{};
+		uint32_t vertexIndices[3]{};
+
+		//Slightly below the closest projected z, no pixel of the triangle can be in front of it
+		float minDepth{};
+
+		//Pixel bounding box, max values excluded
+		int minX{};
+		int minY{};
+		int maxX{};
+		int maxY{};
+
+		//Edge functions of the three edges, each one is positive inside the triangle
+		//Exact integers, from the vertices snapped to m_SubpixelSteps per pixel, see GetEdgeValues
+		//Value at the center of pixel (minX, minY), then how much they change per pixel in x and y
+		int64_t edgeOrigin[3]{};
+		int64_t edgeStepX[3]{};
+		int64_t edgeStepY[3]{};
+		int64_t edgeBias[3]{}; //Top-left rule, 0 when the edge owns the pixels right on it, 1 when it doesn't
+
+		//Same steps as floats, to interpolate from the edge values
+		Vector3 edgeStepXFloat{};
+		Vector3 edgeStepYFloat{};
+		float inverseArea{}; //Turns the edge values into barycentric weights
+
+		//uv and 1 / w of the three vertices, to interpolate the uv anywhere from the edge values
+		Vector3 uOverW{};
+		Vector3 vOverW{};
+		Vector3 inverseW{};
+	};
+
+	//Output of a binning worker for one triangle, in submission order
+	struct BinnedTriangle
+	{
+		ScreenTriangle triangle{}; //Set up, or only the vertices when it has to be clipped
+		uint8_t clippingPlanes{}; //Clipped when the chunks are merged, the clipped vertices are shared by the whole frame
+	};
+
+	//Part of the triangles of an instance, culled and set up by one worker
+	struct BinningChunk
+	{
+		size_t instanceIndex{};
+		size_t firstTriangle{};
+		size_t lastTriangle{}; //Excluded
+		std::span<BinnedTriangle> triangles{}; //In the arena of the worker
+		ScreenRect bounds{}; //Of the triangles that aren't clipped
+		FrameCounters counters{};
+	};
+
+	//Fixed size part of the screen rasterized by one worker
+	struct Tile
+	{
+		//Pixel rectangle, max values excluded
+		int minX{};
+		int minY{};
+		int maxX{};
+		int maxY{};
+
+		//Triangles overlapping the tile, in submission order, in the arena of the frame
+		std::span<uint32_t> triangleIndices{};
+
+		//Rendered this frame, the other tiles keep the pixels of the last frame
+		bool isDirty{};
+
+		//Size of the shaded blocks of its last frame, 1 when every pixel was shaded
+		int shadingRate{ 1 };
+		bool hasHistory{}; //Its pixels come from an earlier frame and can be used to pick the adaptive rate
+
+		//Hierarchical depth, max depth of every 8x8 block of the tile, row by row
+		//A triangle behind every block it overlaps can't pass the depth test of any of its pixels
+		static constexpr int depthBlockSize{ 8 };
+		static constexpr int maxNrDepthBlocks{ 32 };
+		float depthBlockMax[maxNrDepthBlocks]{};
+		uint32_t dirtyDepthBlocks{}; //Written since their max was calculated, the stored max is still an upper bound
+
+		TileStatistics statistics{};
+	};
+
+	//Output of the vertex stage for one instance
+	struct InstanceVertices
+	{
+		VertexOutputStreams streams{};
+		uint32_t version{}; //Of the instance when it was transformed, 0 before the first time
+		size_t nrVertices{}; //Transformed, the coarser levels of detail only use the first vertices
+	};
+
+	//Everything the tile workers read about a frame, written by the vertex stage and the binning
+	//Pipelined frames use two of them in turns, the next frame is prepared while the last one is rasterized
+	struct FrameData
+	{
+		SDL_Surface* pBackBuffer{};
+		int width{}; //Rendered resolution of the frame
+		int height{};
+
+		std::vector<Tile> tiles{};
+		std::span<ScreenTriangle> triangles{}; //Referenced by the tiles, in the arena
+		VertexOutputStreams clippedVertices{}; //Vertices created by the clipping
+		std::vector<InstanceVertices> instanceVertices{}; //One per instance, kept while the instance doesn't move
+
+		bool useFullShadingRate{}; //Set for the frame that refines an idle coarse frame
+		FrameCounters counters{}; //Of the vertex stage and the binning, the tiles have their own
+
+		//Everything that only lives until the frame is presented, reset when the frame data is prepared again
+		FrameArena arena{};
+	};
+
 	class Renderer final
 	{
 	public:
 		Renderer(SDL_Window* pWindow);
+		Renderer(const int width, const int height, const RenderAssets& assets = RenderAssets{}); //Headless, renders in memory without window
 		~Renderer();
 
 		Renderer(const Renderer&) = delete;
@@ -42,38 +291,133 @@ namespace dae
 		void Update(Timer* pTimer);
 		void Render();
 
+		//Pipelined frames: Render returns while the tiles of the frame are rasterized on another thread,
+		//so the input, the update and the vertex stage of the next frame run meanwhile
+		//A frame is presented by the next Render call, one frame later than without pipelining
+		void TogglePipelining(); //P
+		void SetPipelining(bool isEnabled);
+		bool IsPipeliningEnabled() const;
+		//Finish the frame in flight, the back buffer then has the last rendered frame
+		//The options read by the tile workers call it before they change
+		void WaitForFrame();
+
 		bool SaveBufferToImage() const;
 
+		//Used to drive the renderer from a script instead of the input
+		void SetMeshRotation(const float angle);
+		void SetCameraOrigin(const Vector3& origin);
+		const Vector3& GetCameraOrigin() const;
+
+		//Static copies of the vehicle on a grid around the first one, for the scenes with many instances
+		void AddVehicleCopies(int nrCopies);
+
+		//Last rendered frame, the size of the window, call WaitForFrame first when the frames are pipelined
+		//With a render scale below 1 only the top left part of the buffer is used, see SetFrameBudget
+		const uint32_t* GetBackBufferPixels() const;
+		const SDL_PixelFormat* GetBackBufferFormat() const;
+		int GetWidth() const;
+		int GetHeight() const;
+
+		//Dynamic resolution: Update lowers the render scale while the frames take longer than the budget
+		//and brings it back up when there is time left, or as soon as the scene is idle
+		//0 keeps the full resolution, which is the default
+		void SetFrameBudget(float milliseconds);
+		float GetRenderScale() const;
+
 		//Transform vetrices in world space
-		void VertexTransformationFunction(std::vector<Mesh>& mesh) const;
+		void VertexTransformationFunction(const std::vector<MeshInstance>& instances);
 
 		//Display functions
 		//Called by input pressure
+		void ToggleBackFaceCulling(); //F2
+		bool IsBackFaceCullingEnabled() const;
+		void ToggleHierarchicalDepth(); //F1
+		bool IsHierarchicalDepthEnabled() const;
 		void ToggleDisplayZBuffer(); //F4
 		void ToggleRotation(); //F5
 		void ToggleNormalMap(); //F6
 		void CycleShadingMode(); //F7
+		void SetShadingMode(ShadingMode shadingMode);
+		void SetDisplayNormalMap(bool isDisplayed);
+		void CyclePixelKernel(); //F8
+		PixelKernelType GetPixelKernel() const;
+		void ToggleProfiler(); //F10
+		void ToggleVisibilityBuffer(); //F3
+		bool IsVisibilityBufferEnabled() const;
+		void ToggleTextureFilter(); //F11
+		TextureFilter GetTextureFilter() const;
+		void CycleShadingRate(); //R
+		void SetShadingRate(ShadingRate shadingRate);
+		ShadingRate GetShadingRate() const;
+		static const char* GetShadingRateName(ShadingRate shadingRate);
+		void ToggleFrameReuse(); //F12
+		void SetFrameReuse(bool isEnabled);
+		bool IsFrameReuseEnabled() const;
+		void ToggleLevelOfDetail(); //L
+		void SetLevelOfDetail(bool isEnabled);
+		bool IsLevelOfDetailEnabled() const;
+		void ToggleVertexFormat(); //Q, the streams of every mesh are built again in the other format
+		void SetVertexFormat(VertexFormat vertexFormat);
+		VertexFormat GetVertexFormat() const;
+		static const char* GetVertexFormatName(VertexFormat vertexFormat);
+		void ToggleMathMode(); //M
+		void SetMathMode(MathMode mathMode);
+		MathMode GetMathMode() const;
+		static const char* GetMathModeName(MathMode mathMode);
+
+		//Triangles of every level of every mesh and the distance from which it is drawn at the current resolution
+		void PrintLevelsOfDetail(std::ostream& stream) const;
+
+		//Nothing changed since the last frame, the back buffer was kept as it was
+		bool WasFrameSkipped() const;
+
+		FrameProfiler& GetProfiler();
+
+		//Render the current frame with every supported pixel kernel and check they give the same bits as the scalar one
+		//Done with and without the visibility buffer, the options of the user are restored afterwards
+		bool ValidatePixelKernels();
+
+		//Render the current frame with every coarse shading rate and print how far they are from the full rate
+		void CompareShadingRates(std::ostream& stream);
+
+		//Print the memory the meshes hold in both formats and the errors of the quantized vertices against the float ones,
+		//in object space for every mesh and in screen space for the current frame
+		void CompareVertexFormats(std::ostream& stream);
 
 	private:
 		SDL_Window* m_pWindow{};
 
 		SDL_Surface* m_pFrontBuffer{ nullptr };
-		SDL_Surface* m_pBackBuffer{ nullptr };
+		SDL_Surface* m_pBackBuffer{ nullptr }; //Of the last rasterized frame, the one the tile workers write
 		uint32_t* m_pBackBufferPixels{};
-		float* m_pDepthBufferPixels{};
+		float* m_pDepthBufferPixels{}; //Only used by the tile workers, one frame is rasterized at a time
+		uint32_t* m_pVisibilityBufferPixels{}; //Index in the triangles of the rasterized frame of the closest triangle
+		static constexpr uint32_t m_NoTriangle{ UINT32_MAX };
+		uint32_t m_ClearColor{};
 
 		Camera m_Camera{ {0,0,0}, 45 };
 
 		//Loaded texture for pixel shading
-		Texture* m_pTexture;
-		Texture* m_pNormalMap;
-		Texture* m_pGlossyMap;
-		Texture* m_pSpecularMap;
+		Material* m_pMaterial{};
 		
-		//To calculate the size of the window
+		//Size of the window and of the buffers, also the row stride of the buffers
+		int m_BufferWidth{};
+		int m_BufferHeight{};
+
+		//Rendered resolution, smaller than the buffers when the render scale is below 1
 		int m_Width{};
 		int m_Height{};
 
+		//Dynamic resolution
+		static constexpr float m_MinRenderScale{ 0.5f };
+		static constexpr float m_RenderScaleStep{ 1.0f / 32 }; //Smaller changes are ignored, every change rebuilds the tiles
+		static constexpr float m_FrameTimeSmoothing{ 0.1f }; //Weight of the last frame in the average
+		static constexpr int m_NrSettleFrames{ 10 }; //Frames between two changes, so the average follows the last one
+		float m_FrameBudgetMs{ 0.0f };
+		float m_RenderScale{ 1.0f };
+		float m_AverageFrameMs{ 0.0f };
+		int m_NrFramesSinceScaleChange{ 0 };
+
 		const ColorRGB m_AmbiantColor{ 0.3f, 0.3f, 0.3f };
 
 		//Inpute influenced variables
@@ -81,6 +425,29 @@ namespace dae
 		bool m_IsRotationEnabled{ false };
 		bool m_DisplayNormalMap{ false };
 		ShadingMode m_ShadingMode{ ShadingMode::ObservedArea };
+		PixelKernelType m_PixelKernel{ PixelKernel::GetBestSupported() };
+		TextureFilter m_TextureFilter{ TextureFilter::Trilinear };
+		bool m_UseVisibilityBuffer{ false }; //Shade every pixel once after the depth of the tile is known
+		bool m_IsBackFaceCullingEnabled{ true };
+		bool m_UseHierarchicalDepth{ true }; //Skip the triangles hidden behind the depth blocks of a tile
+		bool m_UseFrameReuse{ true }; //Skip the unchanged frames and only render the tiles of the moved instances
+		bool m_UseLevelOfDetail{ true }; //Draw the far instances with less triangles, see MeshSimplifier
+		ShadingRate m_ShadingRate{ ShadingRate::Full };
+		MathMode m_MathMode{ MathMode::Precise };
+
+		//Adaptive shading rate, mean luminance step (0 - 255) between pixels 4 apart in the last frame of a tile
+		static constexpr int m_ContrastSampleSpacing{ 4 }; //The largest block, so a coarse frame doesn't hide its own contrast
+		static constexpr float m_MaxContrast4x4{ 4.0f };
+		static constexpr float m_MaxContrast2x2{ 16.0f };
+
+		//State of the last rendered frame
+		bool m_HasFrameState{ false };
+		bool m_WasFrameSkipped{ false };
+		FrameStateKey m_FrameState{};
+		std::vector<InstanceFrameState> m_InstanceStates{};
+
+		//Stage times and counters of the last frames
+		FrameProfiler m_Profiler{};
 
 		//Mesh transform
 		float m_MeshRotationAngle{ 0 };
@@ -88,31 +455,175 @@ namespace dae
 		const Vector3 m_MeshPosition{ 0,0,0.0f };
 
 
-		//All the meshes
-		std::vector<Mesh> m_MeshesWorld{}; //The vector of mesh on which we apply all the transformation
-		std::vector<Mesh> m_NonTransformedMeshes{}; //The meshes before transformation, so we avoid creating a vector each frame
-
-		//Vectors to stors vetrices and indices from ParseOBJ function
-		std::vector<Vertex> m_MeshVetrices{};
-		std::vector<uint32_t> m_MeshIndices{};
-
-		//To check if a triangle could be visible on a certain pixel
-		bool HitTest_Triangle(const Vector2& v0, const Vector2& v1, const Vector2& v2, const Vector2& pixel, Vector3& barycentricWeights) const;
-
-		//Render a certain pixel of a mesh
-		void RenderAPixel(const int px, const int py, const Vector4& v0, const Vector4& v1, const Vector4& v2, const Mesh& mesh, const int index);
-
-		//Render all the pixels of a mesh
-		void RenderMeshes(std::vector<Mesh>& meshesWorld);
+		//All the meshes and their instances
+		Scene m_Scene{};
+		size_t m_VehicleMesh{};
+		size_t m_VehicleInstance{}; //The instance rotated by the input
+
+		//Screen tiles, each one owns its part of the depth and back buffer
+		static constexpr int m_TileSize{ 32 };
+		static constexpr int m_NrDepthBlocksX{ m_TileSize / Tile::depthBlockSize };
+		static_assert(m_NrDepthBlocksX * m_NrDepthBlocksX <= Tile::maxNrDepthBlocks, "A tile has one dirty bit per depth block");
+		static constexpr float m_DepthMargin{ 1e-5f }; //About 80 float steps below 1, where all the depth values are
+
+		//Vertex stage, reused every frame
+		static constexpr size_t m_VertexChunkSize{ 1024 }; //Multiple of VertexKernel::padding
+		static_assert(m_VertexChunkSize % VertexKernel::padding == 0, "The chunks can't split a padded register");
+		std::vector<VertexKernel::TransformConstants> m_TransformConstants{}; //One per instance
+		std::vector<uint8_t> m_IsInstanceVisible{}; //1 for the instances inside of the view frustum, see Scene::CullInstances
+
+		//Levels of detail, every instance uses the coarsest level that moves its surface less than this many pixels on screen
+		//Half a pixel, the error of a level is a mean and not the largest distance
+		static constexpr float m_MaxLodPixelError{ 0.5f };
+		std::vector<uint8_t> m_InstanceLods{}; //Selected for the visible instances by SelectLods
+
+		//Pixels on screen of one unit at a distance of one unit
+		float GetLodPixelsPerUnit() const;
+		void SelectLods(const Scene& scene);
+
+		//Triangles per binning worker, large enough to hide the cost of a task
+		static constexpr size_t m_BinningChunkSize{ 4096 };
+
+		//Fixed point subpixel precision of the rasterizer, 8 bits
+		//With the guard band the edge values stay far below the range of an int64
+		static constexpr int m_SubpixelBits{ 8 };
+		static constexpr int64_t m_SubpixelSteps{ 1 << m_SubpixelBits };
+
+		//Calculate the edge functions of a triangle once, so the pixel loop only has to step them
+		bool SetupTriangle(ScreenTriangle& triangle) const;
+		//Exact edge values at the center of a pixel, and the same as floats for the interpolation
+		void GetEdgeValues(const ScreenTriangle& triangle, int px, int py, int64_t edgeValues[3]) const;
+		Vector3 GetEdgeWeights(const ScreenTriangle& triangle, int px, int py) const;
+		//Pixels [begin, end[ of the row inside of the triangle, clamped to [minX, maxX[, false when there are none
+		//A pixel on a shared edge belongs to exactly one of the triangles
+		bool GetCoveredSpan(const ScreenTriangle& triangle, int py, int minX, int maxX, int& begin, int& end) const;
+
+		//The raster and shading functions are specialized for every ShaderConfig, RenderMeshes picks one per frame
+		using TileFunction = void(Renderer::*)(Tile& tile);
+		TileFunction GetTileFunction() const;
+		template<ShadingMode Mode>
+		TileFunction GetTileFunction(const bool useNormalMap, const bool useFastMath) const;
+
+		//Without pipelining the same frame data is used every time
+		FrameData m_Frames[2]{};
+		FrameData* m_pPreparedFrame{ &m_Frames[0] }; //Written by the vertex stage and the binning
+		FrameData* m_pRasterizedFrame{ &m_Frames[0] }; //Read by the tile workers
+		FrameData* m_pFrameToPresent{}; //Rasterized and not presented yet
+		const FrameData* m_pHistoryFrame{ &m_Frames[0] }; //Last rasterized frame, the adaptive shading rate measures its pixels
+		TileFunction m_RasterizedTileFunction{};
+
+		//The raster thread runs the tile workers of the pipelined frames
+		bool m_UsePipelining{ false };
+		bool m_HasFrameInFlight{ false }; //Only used by the render thread, m_IsRasterizing is shared
+		std::mutex m_RasterMutex{};
+		std::condition_variable m_RasterRequested{};
+		std::condition_variable m_RasterDone{};
+		bool m_IsRasterizing{ false };
+		bool m_IsStopping{ false };
+		std::thread m_RasterThread;
+
+		//Render a certain pixel covered by a triangle
+		template<typename Shader>
+		void RenderAPixel(const int px, const int py, const ScreenTriangle& triangle, const Vector3& barycentrics, TileStatistics& statistics);
+
+		//Interpolate the attributes of a visible pixel and shade it
+		template<typename Shader>
+		void ShadeFragment(const int px, const int py, const ScreenTriangle& triangle, const Vector3& barycentrics,
+			const float depth, const float wInterpolated, const Vector2& uv, TileStatistics& statistics);
+
+		//Perspective correct w and uv
+		template<typename Shader>
+		void InterpolatePerspective(const ScreenTriangle& triangle, const Vector3& barycentrics, float& wInterpolated, Vector2& uv) const;
+
+		//Second pass of the visibility buffer, the barycentrics are recalculated from the stored triangle
+		//With a block kernel, the pixels of a block that show the same triangle are interpolated together
+		template<typename Shader>
+		void ShadeVisibilityBuffer(const Tile& tile, PixelKernel::BlockFunction blockFunction, TileStatistics& statistics);
+		//The weights are stepped from the pixel firstX of the row, the start of its block, so both paths give the same bits
+		template<typename Shader>
+		void ShadeVisibilityPixel(const int px, const int py, const int firstX, TileStatistics& statistics);
+		//One shaded pixel per triangle and block of shadingRate x shadingRate pixels
+		template<typename Shader>
+		void ShadeVisibilityBufferCoarse(const Tile& tile, int shadingRate, TileStatistics& statistics);
+
+		//Sample the textures of an interpolated pixel, shade it and write it in the back buffer
+		template<typename Shader>
+		void ShadePixel(const int pixelNr, Vertex_Out& interpolatedVertex, const TextureGradient& gradient);
+
+		//uv gradient of the 2x2 quad of the pixel, empty when the textures don't need it
+		template<typename Shader>
+		TextureGradient GetTextureGradient(const ScreenTriangle& triangle, const int px, const int py) const;
+		MaterialSample SampleMaterial(const Vector2& uv, const TextureGradient& gradient) const;
+
+		//Walk the pixels of a triangle inside of a rectangle, max values excluded
+		//The scalar version is the reference, the block version uses the SIMD kernels on 8 pixels at once
+		template<typename Shader>
+		void RasterizeTriangleScalar(const ScreenTriangle& triangle, const int minX, const int minY, const int maxX, const int maxY, TileStatistics& statistics);
+		template<typename Shader>
+		void ShadeBlockLane(const ScreenTriangle& triangle, const PixelBlock& block, const int lane, const int px, const int py);
+		KernelTriangle GetKernelTriangle(const ScreenTriangle& triangle, bool useFastMath) const;
+		template<typename Shader>
+		void RasterizeTriangleBlocks(const ScreenTriangle& triangle, const int minX, const int minY, const int maxX, const int maxY, PixelKernel::BlockFunction blockFunction, TileStatistics& statistics);
+
+		//Render all the pixels of the mesh instances
+		//Pipelined, the vertex stage and the binning run while the last frame is rasterized and the tiles are rasterized on the raster thread
+		void RenderMeshes(Scene& scene);
+		//Vertex stage and binning in m_pPreparedFrame, returns false when the last frame is reused as it is
+		bool PrepareFrame(Scene& scene);
+		//Render the dirty tiles of m_pRasterizedFrame
+		void RasterizeFrame();
+		void RasterLoop();
+		//The tiles that are not rendered keep the pixels of the last frame, which is in the other frame data when pipelined
+		void KeepUnchangedTiles(FrameData& frame, const FrameData& lastFrame) const;
+		void AddFrameStatistics(const FrameData& frame);
+
+		//Compare the frame with the last rendered one and flag the moved instances
+		//Returns false when the whole frame has to be rendered
+		bool UpdateFrameState(const std::vector<MeshInstance>& instances);
+		FrameStateKey GetFrameStateKey() const;
+		//Returns the number of tiles to render
+		int MarkDirtyTiles(bool isReusingFrame);
+
+		//Split the screen in tiles, for both frame data
+		void InitTiles();
+
+		//Primitive assembly: cull the triangles that can't be seen, clip the ones crossing the near plane or the guard band
+		//and sort the rest into the tiles they overlap
+		//The chunks are culled and set up in parallel, then merged in submission order
+		void BinTriangles(const std::vector<MeshInstance>& instances);
+		void BinTriangleChunk(BinningChunk& chunk, const std::vector<MeshInstance>& instances) const;
+		//The new triangles are added at frame.triangles[nrTriangles]
+		void AddClippedTriangles(const ScreenTriangle& triangle, uint8_t outsidePlanes, ScreenRect& bounds, size_t& nrTriangles);
+		//Bounding box, edge functions and interpolation constants, false when it can't cover any pixel
+		bool PrepareTriangle(ScreenTriangle& triangle) const;
+		//Give every tile the triangles overlapping it, once all of them are known
+		void FillTileTriangles(FrameData& frame) const;
+
+		//Clear and rasterize all the triangles of a tile
+		template<typename Shader>
+		void RenderTile(Tile& tile);
+
+		//Size of the shaded blocks of the tile this frame, called before the tile is cleared
+		//The adaptive rate measures the same tile of m_pHistoryFrame, which is this frame data when not pipelined
+		int GetTileShadingRate(const Tile& tile) const;
+		float GetTileContrast(const Tile& tile) const;
+
+		//Depth blocks of the tile overlapped by a rectangle, max values excluded
+		uint32_t GetDepthBlockMask(const Tile& tile, const int minX, const int minY, const int maxX, const int maxY) const;
+		//Compare the triangle with the max depth of the blocks, the dirty ones are calculated again first
+		bool IsOccluded(Tile& tile, const ScreenTriangle& triangle, const uint32_t depthBlockMask) const;
 
 		//Transform X and Y world value into screenspace values
 		Vector2 ToScreenSpace(const float x, const float y) const;
+		//Screen space x and y, projected z and w of a clip space position
+		Vector4 ToScreenPosition(const Vector4& clipPos) const;
 
 		//Remap a value between min and max
 		float Remap(const float colorValue, const float min, const float max) const;
 
 		//Shade a pixel with texture values and Input options
-		ColorRGB PixelShading(const Vertex_Out& vOut) const;
+		template<typename Shader>
+		ColorRGB PixelShading(const Vertex_Out& vOut, const MaterialSample& material) const;
 
 		void Render_W4_Part1();
 
@@ -120,6 +631,12 @@ namespace dae
 
 
 		//Helper functions
+		void Initialize(const RenderAssets& assets); //Buffers, camera and scene, once the size is known
 		void UpdateRotation(Timer* pTimer);
+		void UpdateRenderScale(float elapsedSeconds);
+		void SetRenderScale(float scale);
+
+		//Copy the back buffer of the frame to the window, scaled up when its render scale is below 1
+		void Present(const FrameData& frame);
 	};
 }
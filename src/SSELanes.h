@@ -0,0 +1,58 @@
+#pragma once
+
+//Lanes of the SSE2 kernels, see PixelKernelImpl.h and VertexKernelImpl.h for how they are used
+//SSE2 is part of every x64 cpu, so every translation unit can include this
+
+#include <cstdint>
+#include <emmintrin.h>
+
+namespace dae
+{
+	namespace
+	{
+		//The fallback when AVX2 is missing
+		struct SSELanes
+		{
+			using Float = __m128;
+			static constexpr int count{ 4 };
+
+			static Float Set1(const float value) { return _mm_set1_ps(value); }
+			static Float LaneIndex() { return _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f); }
+			static Float Load(const float* pValues) { return _mm_loadu_ps(pValues); }
+			static Float LoadUnsigned16(const uint16_t* pValues)
+			{
+				const __m128i values{ _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pValues)) };
+				return _mm_cvtepi32_ps(_mm_unpacklo_epi16(values, _mm_setzero_si128()));
+			}
+			static Float LoadSigned16(const int16_t* pValues)
+			{
+				//Every value in the high half of a 32 bit lane, the arithmetic shift extends the sign
+				const __m128i values{ _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pValues)) };
+				return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(values, values), 16));
+			}
+			static void Store(float* pValues, const Float value) { _mm_storeu_ps(pValues, value); }
+
+			static Float Add(const Float a, const Float b) { return _mm_add_ps(a, b); }
+			static Float Sub(const Float a, const Float b) { return _mm_sub_ps(a, b); }
+			static Float Mul(const Float a, const Float b) { return _mm_mul_ps(a, b); }
+			static Float Div(const Float a, const Float b) { return _mm_div_ps(a, b); }
+			static Float Sqrt(const Float a) { return _mm_sqrt_ps(a); }
+			static Float ReciprocalEstimate(const Float a) { return _mm_rcp_ps(a); }
+			static Float RsqrtEstimate(const Float a) { return _mm_rsqrt_ps(a); }
+			static Float Abs(const Float a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+			static Float Max(const Float a, const Float b) { return _mm_max_ps(a, b); }
+			static Float CopySign(const Float magnitude, const Float sign)
+			{
+				const Float signBit{ _mm_set1_ps(-0.0f) };
+				return _mm_or_ps(_mm_andnot_ps(signBit, magnitude), _mm_and_ps(signBit, sign));
+			}
+
+			static Float Less(const Float a, const Float b) { return _mm_cmplt_ps(a, b); }
+			static Float Greater(const Float a, const Float b) { return _mm_cmpgt_ps(a, b); }
+			static Float GreaterEqual(const Float a, const Float b) { return _mm_cmpge_ps(a, b); }
+
+			static Float Or(const Float a, const Float b) { return _mm_or_ps(a, b); }
+			static int MoveMask(const Float a) { return _mm_movemask_ps(a); }
+		};
+	}
+}
@@ -0,0 +1,122 @@
+//Project includes
+#include "Scene.h"
+
+using namespace dae;
+
+namespace
+{
+	void AssignStreams(MeshData& mesh, const VertexFormat vertexFormat)
+	{
+		if (vertexFormat == VertexFormat::Quantized)
+		{
+			mesh.quantizedStreams.Assign(mesh.vertices);
+			mesh.streams = VertexInputStreams{};
+		}
+		else
+		{
+			mesh.streams.Assign(mesh.vertices);
+			mesh.quantizedStreams = QuantizedVertexStreams{};
+		}
+	}
+}
+
+void MeshData::SetStorage(std::vector<Vertex>&& newVertices, std::vector<uint32_t>&& newIndices)
+{
+	vertexStorage = std::move(newVertices);
+	indexStorage = std::move(newIndices);
+	pMappedFile.reset();
+
+	vertices = vertexStorage;
+	indices = indexStorage;
+}
+
+std::span<const uint32_t> MeshData::GetIndices(const size_t lod) const
+{
+	return indices.subspan(lods[lod].firstIndex, lods[lod].nrIndices);
+}
+
+size_t Scene::AddMesh(MeshData&& mesh)
+{
+	if (mesh.lods.empty())
+	{
+		mesh.lods.push_back({ 0, static_cast<uint32_t>(mesh.indices.size()), static_cast<uint32_t>(mesh.vertices.size()), 0.0f });
+	}
+
+	AssignStreams(mesh, m_VertexFormat);
+	mesh.bounds = BoundingBox{};
+	for (const Vertex& vertex : mesh.vertices)
+	{
+		mesh.bounds.Add(vertex.position);
+	}
+	m_Meshes.push_back(std::make_unique<MeshData>(std::move(mesh)));
+	return m_Meshes.size() - 1;
+}
+
+void Scene::SetVertexFormat(const VertexFormat vertexFormat)
+{
+	if (vertexFormat == m_VertexFormat) return;
+
+	m_VertexFormat = vertexFormat;
+	for (const std::unique_ptr<MeshData>& pMesh : m_Meshes)
+	{
+		AssignStreams(*pMesh, vertexFormat);
+	}
+}
+
+size_t Scene::GetNrStreamBytes() const
+{
+	size_t nrBytes{ 0 };
+	for (const std::unique_ptr<MeshData>& pMesh : m_Meshes)
+	{
+		nrBytes += pMesh->streams.GetNrBytes() + pMesh->quantizedStreams.GetNrBytes();
+	}
+	return nrBytes;
+}
+
+size_t Scene::AddInstance(const size_t meshId, const Matrix& worldMatrix)
+{
+	MeshInstance instance{};
+	instance.pMesh = m_Meshes[meshId].get();
+	instance.worldMatrix = worldMatrix;
+
+	m_InstanceBounds.push_back(BoundingBox::Transform(instance.pMesh->bounds, worldMatrix));
+	m_Instances.push_back(std::move(instance));
+	return m_Instances.size() - 1;
+}
+
+void Scene::SetInstanceTransform(const size_t instanceId, const Matrix& worldMatrix)
+{
+	m_Instances[instanceId].worldMatrix = worldMatrix;
+	m_InstanceBounds[instanceId] = BoundingBox::Transform(m_Instances[instanceId].pMesh->bounds, worldMatrix);
+	m_HasMovedInstances = true;
+}
+
+void Scene::UpdateBounds()
+{
+	//The tree was built for fewer instances
+	if (m_BoundingVolumeHierarchy.GetNrItems() != m_Instances.size())
+	{
+		m_BoundingVolumeHierarchy.Build(m_InstanceBounds);
+	}
+	else if (m_HasMovedInstances)
+	{
+		m_BoundingVolumeHierarchy.Refit(m_InstanceBounds);
+	}
+	m_HasMovedInstances = false;
+}
+
+size_t Scene::CullInstances(const Frustum& frustum, std::vector<uint8_t>& isVisible) const
+{
+	isVisible.resize(m_Instances.size());
+	return m_BoundingVolumeHierarchy.Cull(frustum, m_InstanceBounds, isVisible);
+}
+
+BoundingBox Scene::GetBounds() const
+{
+	BoundingBox bounds{};
+	for (const BoundingBox& instanceBounds : m_InstanceBounds)
+	{
+		bounds.Add(instanceBounds);
+	}
+	return bounds;
+}
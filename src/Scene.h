@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "BoundingVolumeHierarchy.h"
+#include "DataTypes.h"
+#include "MappedFile.h"
+#include "VertexKernel.h"
+
+namespace dae
+{
+	//One level of detail of a mesh, a range of its indices
+	//Stored in the mesh cache as is
+	struct MeshLod
+	{
+		uint32_t firstIndex{};
+		uint32_t nrIndices{};
+		uint32_t nrVertices{}; //Only the first nrVertices vertices are used by this level
+		float error{}; //How far the surface moved from the full mesh in object space, see MeshSimplifier::Simplify
+	};
+
+	//Geometry loaded once and shared by every instance drawing it, only the vertex streams change after loading
+	struct MeshData
+	{
+		//Views on the storage of the mesh or on its mapped cache file, see MeshCache
+		std::span<const Vertex> vertices{};
+		std::span<const uint32_t> indices{}; //Of every level behind each other
+		PrimitiveTopology primitiveTopology{ PrimitiveTopology::TriangleList };
+
+		//lods[0] is the full mesh, the next ones have less triangles, see MeshSimplifier
+		//A mesh without levels gets a single one for all its indices in Scene::AddMesh
+		std::vector<MeshLod> lods{};
+
+		//Only one of them is used, moving the mesh keeps the views valid
+		std::vector<Vertex> vertexStorage{};
+		std::vector<uint32_t> indexStorage{};
+		std::unique_ptr<const MappedFile> pMappedFile{};
+
+		//Copies of the vertices for the vertex kernels, only the ones of the vertex format of the scene are filled
+		VertexInputStreams streams{};
+		QuantizedVertexStreams quantizedStreams{};
+		//Object space box of the vertices, filled by Scene::AddMesh
+		BoundingBox bounds{};
+
+		void SetStorage(std::vector<Vertex>&& newVertices, std::vector<uint32_t>&& newIndices);
+		std::span<const uint32_t> GetIndices(size_t lod) const;
+	};
+
+	//One placement of a mesh in the world
+	struct MeshInstance
+	{
+		const MeshData* pMesh{};
+		Matrix worldMatrix{};
+	};
+
+	class Scene final
+	{
+	public:
+		Scene() = default;
+		~Scene() = default;
+
+		Scene(const Scene&) = delete;
+		Scene(Scene&&) noexcept = delete;
+		Scene& operator=(const Scene&) = delete;
+		Scene& operator=(Scene&&) noexcept = delete;
+
+		//Returns the id to use to create instances of the mesh
+		size_t AddMesh(MeshData&& mesh);
+
+		//Builds the streams of the format for every mesh and frees the ones of the other format
+		//The vertex stage can't run meanwhile, the meshes are added with the current format
+		void SetVertexFormat(VertexFormat vertexFormat);
+		VertexFormat GetVertexFormat() const { return m_VertexFormat; }
+		//Vertex streams of all the meshes, the vertices they are built from not included
+		size_t GetNrStreamBytes() const;
+
+		//Returns the id to use to move the instance
+		size_t AddInstance(size_t meshId, const Matrix& worldMatrix);
+		void SetInstanceTransform(size_t instanceId, const Matrix& worldMatrix);
+
+		//The transforms can only be changed with SetInstanceTransform, the bounding boxes follow them
+		const std::vector<MeshInstance>& GetInstances() const { return m_Instances; }
+
+		//Rebuilds the hierarchy after instances were added, refits it after they moved
+		void UpdateBounds();
+		//One flag per instance, 1 when it can be in the view, returns the number of visible instances
+		//Call UpdateBounds first, isVisible only allocates when instances were added
+		size_t CullInstances(const Frustum& frustum, std::vector<uint8_t>& isVisible) const;
+
+		//World space box of every instance, same order as the instances
+		const std::vector<BoundingBox>& GetInstanceBounds() const { return m_InstanceBounds; }
+		//Box of all the instances, empty when there are none
+		BoundingBox GetBounds() const;
+
+		const MeshData& GetMesh(const size_t meshId) const { return *m_Meshes[meshId]; }
+		size_t GetNrMeshes() const { return m_Meshes.size(); }
+
+	private:
+		//Stored behind pointers so the instances can keep pointing to them when meshes are added
+		//Only SetVertexFormat changes them after they are added
+		std::vector<std::unique_ptr<MeshData>> m_Meshes{};
+		VertexFormat m_VertexFormat{ VertexFormat::Float };
+		std::vector<MeshInstance> m_Instances{};
+
+		//World space box of every instance, kept up to date by SetInstanceTransform
+		std::vector<BoundingBox> m_InstanceBounds{};
+		BoundingVolumeHierarchy m_BoundingVolumeHierarchy{};
+		bool m_HasMovedInstances{};
+	};
+}
@@ -0,0 +1,407 @@
+//Project includes
+#include "VertexKernel.h"
+#include "VertexKernelImpl.h"
+#include "SSELanes.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace dae
+{
+	namespace
+	{
+		//One vertex at a time, the reference of the SIMD kernels
+		struct ScalarLanes
+		{
+			using Float = float;
+			static constexpr int count{ 1 };
+
+			static Float Set1(const float value) { return value; }
+			static Float Load(const float* pValues) { return *pValues; }
+			static Float LoadUnsigned16(const uint16_t* pValues) { return static_cast<float>(*pValues); }
+			static Float LoadSigned16(const int16_t* pValues) { return static_cast<float>(*pValues); }
+			static void Store(float* pValues, const Float value) { *pValues = value; }
+
+			static Float Add(const Float a, const Float b) { return a + b; }
+			static Float Sub(const Float a, const Float b) { return a - b; }
+			static Float Mul(const Float a, const Float b) { return a * b; }
+			static Float Div(const Float a, const Float b) { return a / b; }
+			static Float Sqrt(const Float a) { return std::sqrt(a); }
+			static Float Abs(const Float a) { return std::fabs(a); }
+			static Float Max(const Float a, const Float b) { return a > b ? a : b; } //Same as maxps, b when they are equal
+			static Float CopySign(const Float magnitude, const Float sign) { return std::copysign(magnitude, sign); }
+
+			//Comparisons give a 0 or 1 bit mask directly
+			static bool Less(const Float a, const Float b) { return a < b; }
+			static bool Greater(const Float a, const Float b) { return a > b; }
+			static bool Or(const bool a, const bool b) { return a || b; }
+			static int MoveMask(const bool a) { return a ? 1 : 0; }
+		};
+
+		size_t GetPaddedSize(const size_t size)
+		{
+			return (size + VertexKernel::padding - 1) / VertexKernel::padding * VertexKernel::padding;
+		}
+
+		//Fixed point in [offset, offset + 65535 * scale], the offset and scale come from the range of the values
+		void SetQuantizationRange(const float minValue, const float maxValue, float& offset, float& scale)
+		{
+			offset = minValue;
+			scale = (maxValue - minValue) / std::numeric_limits<uint16_t>::max();
+		}
+		uint16_t Quantize(const float value, const float offset, const float scale)
+		{
+			if (scale <= 0.0f) return 0;
+			const long quantized{ std::lround((value - offset) / scale) };
+			return static_cast<uint16_t>(std::clamp<long>(quantized, 0, std::numeric_limits<uint16_t>::max()));
+		}
+
+		//Angle between two directions of any length, atan2 stays precise for the tiny angles of the quantization
+		float GetAngleDegrees(const Vector3& a, const Vector3& b)
+		{
+			return std::atan2(Vector3::Cross(a, b).Magnitude(), Vector3::Dot(a, b)) * TO_DEGREES;
+		}
+
+		//Projects the direction on the octahedron |x| + |y| + |z| = 1 and folds the lower half over the diagonals of the upper one
+		//Rounding both coordinates to the nearest value isn't always the closest direction, so the four neighbours are tried
+		void EncodeOctahedral(const Vector3& direction, int16_t& outU, int16_t& outV)
+		{
+			outU = 0;
+			outV = 0;
+			const float sum{ std::fabs(direction.x) + std::fabs(direction.y) + std::fabs(direction.z) };
+			if (sum <= 0.0f) return;
+
+			float u{ direction.x / sum };
+			float v{ direction.y / sum };
+			if (direction.z < 0.0f)
+			{
+				const float foldedU{ (1.0f - std::fabs(v)) * (u >= 0.0f ? 1.0f : -1.0f) };
+				v = (1.0f - std::fabs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+				u = foldedU;
+			}
+
+			const float range{ QuantizedVertexStreams::octahedralRange };
+			const float lowU{ std::floor(u * range) };
+			const float lowV{ std::floor(v * range) };
+			float bestAngle{ std::numeric_limits<float>::max() };
+			for (int offsetV{ 0 }; offsetV < 2; ++offsetV)
+			{
+				for (int offsetU{ 0 }; offsetU < 2; ++offsetU)
+				{
+					const int16_t candidateU{ static_cast<int16_t>(std::clamp(lowU + offsetU, -range, range)) };
+					const int16_t candidateV{ static_cast<int16_t>(std::clamp(lowV + offsetV, -range, range)) };
+
+					Vector3 decoded{};
+					DecodeOctahedral<ScalarLanes>(&candidateU, &candidateV, decoded.x, decoded.y, decoded.z);
+					const float angle{ GetAngleDegrees(decoded, direction) };
+					if (angle < bestAngle)
+					{
+						bestAngle = angle;
+						outU = candidateU;
+						outV = candidateV;
+					}
+				}
+			}
+		}
+	}
+
+	void VertexInputStreams::Assign(const std::span<const Vertex> vertices)
+	{
+		size = vertices.size();
+		paddedSize = GetPaddedSize(size);
+		m_Storage.assign(m_NrStreams * paddedSize, 0.0f);
+
+		float* streams[m_NrStreams]{};
+		for (int stream{ 0 }; stream < m_NrStreams; ++stream)
+		{
+			streams[stream] = m_Storage.data() + stream * paddedSize;
+		}
+
+		for (size_t i{ 0 }; i < size; ++i)
+		{
+			const Vertex& vertex{ vertices[i] };
+			streams[0][i] = vertex.position.x;
+			streams[1][i] = vertex.position.y;
+			streams[2][i] = vertex.position.z;
+			streams[3][i] = vertex.normal.x;
+			streams[4][i] = vertex.normal.y;
+			streams[5][i] = vertex.normal.z;
+			streams[6][i] = vertex.tangent.x;
+			streams[7][i] = vertex.tangent.y;
+			streams[8][i] = vertex.tangent.z;
+			streams[9][i] = vertex.uv.x;
+			streams[10][i] = vertex.uv.y;
+		}
+
+		pPositionX = streams[0];
+		pPositionY = streams[1];
+		pPositionZ = streams[2];
+		pNormalX = streams[3];
+		pNormalY = streams[4];
+		pNormalZ = streams[5];
+		pTangentX = streams[6];
+		pTangentY = streams[7];
+		pTangentZ = streams[8];
+		pU = streams[9];
+		pV = streams[10];
+	}
+	size_t VertexInputStreams::GetNrBytes() const
+	{
+		return m_Storage.size() * sizeof(float);
+	}
+
+	void QuantizedVertexStreams::Assign(const std::span<const Vertex> vertices)
+	{
+		size = vertices.size();
+		paddedSize = GetPaddedSize(size);
+		m_UnsignedStorage.assign(m_NrUnsignedStreams * paddedSize, 0);
+		m_SignedStorage.assign(m_NrSignedStreams * paddedSize, 0);
+
+		uint16_t* unsignedStreams[m_NrUnsignedStreams]{};
+		for (int stream{ 0 }; stream < m_NrUnsignedStreams; ++stream)
+		{
+			unsignedStreams[stream] = m_UnsignedStorage.data() + stream * paddedSize;
+		}
+		int16_t* signedStreams[m_NrSignedStreams]{};
+		for (int stream{ 0 }; stream < m_NrSignedStreams; ++stream)
+		{
+			signedStreams[stream] = m_SignedStorage.data() + stream * paddedSize;
+		}
+
+		//The ranges of the mesh, the uvs can go outside 0 - 1 to repeat the texture
+		Vector3 minPosition{ std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+		Vector3 maxPosition{ -minPosition };
+		Vector2 minUV{ std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+		Vector2 maxUV{ -minUV };
+		for (const Vertex& vertex : vertices)
+		{
+			for (int axis{ 0 }; axis < 3; ++axis)
+			{
+				minPosition[axis] = std::min(minPosition[axis], vertex.position[axis]);
+				maxPosition[axis] = std::max(maxPosition[axis], vertex.position[axis]);
+			}
+			minUV.x = std::min(minUV.x, vertex.uv.x);
+			minUV.y = std::min(minUV.y, vertex.uv.y);
+			maxUV.x = std::max(maxUV.x, vertex.uv.x);
+			maxUV.y = std::max(maxUV.y, vertex.uv.y);
+		}
+		if (vertices.empty())
+		{
+			minPosition = maxPosition = Vector3{};
+			minUV = maxUV = Vector2{};
+		}
+		for (int axis{ 0 }; axis < 3; ++axis)
+		{
+			SetQuantizationRange(minPosition[axis], maxPosition[axis], positionOffset[axis], positionScale[axis]);
+		}
+		SetQuantizationRange(minUV.x, maxUV.x, uvOffset[0], uvScale[0]);
+		SetQuantizationRange(minUV.y, maxUV.y, uvOffset[1], uvScale[1]);
+
+		for (size_t i{ 0 }; i < size; ++i)
+		{
+			const Vertex& vertex{ vertices[i] };
+			unsignedStreams[0][i] = Quantize(vertex.position.x, positionOffset[0], positionScale[0]);
+			unsignedStreams[1][i] = Quantize(vertex.position.y, positionOffset[1], positionScale[1]);
+			unsignedStreams[2][i] = Quantize(vertex.position.z, positionOffset[2], positionScale[2]);
+			unsignedStreams[3][i] = Quantize(vertex.uv.x, uvOffset[0], uvScale[0]);
+			unsignedStreams[4][i] = Quantize(vertex.uv.y, uvOffset[1], uvScale[1]);
+			EncodeOctahedral(vertex.normal, signedStreams[0][i], signedStreams[1][i]);
+			EncodeOctahedral(vertex.tangent, signedStreams[2][i], signedStreams[3][i]);
+		}
+
+		pPositionX = unsignedStreams[0];
+		pPositionY = unsignedStreams[1];
+		pPositionZ = unsignedStreams[2];
+		pU = unsignedStreams[3];
+		pV = unsignedStreams[4];
+		pNormalU = signedStreams[0];
+		pNormalV = signedStreams[1];
+		pTangentU = signedStreams[2];
+		pTangentV = signedStreams[3];
+
+		//Decoded like the kernels do, a zero normal or tangent has no direction to compare
+		maxPositionError = 0.0f;
+		maxUVError = 0.0f;
+		maxNormalAngle = 0.0f;
+		maxTangentAngle = 0.0f;
+		for (size_t i{ 0 }; i < size; ++i)
+		{
+			const Vertex& vertex{ vertices[i] };
+			const InputVertices<ScalarLanes> decoded{ LoadVertices<ScalarLanes>(*this, i) };
+
+			const Vector3 position{ decoded.positionX, decoded.positionY, decoded.positionZ };
+			maxPositionError = std::max(maxPositionError, (position - vertex.position).Magnitude());
+			maxUVError = std::max({ maxUVError, std::fabs(decoded.u - vertex.uv.x), std::fabs(decoded.v - vertex.uv.y) });
+
+			if (vertex.normal.SqrMagnitude() > 0.0f)
+			{
+				maxNormalAngle = std::max(maxNormalAngle, GetAngleDegrees({ decoded.normalX, decoded.normalY, decoded.normalZ }, vertex.normal));
+			}
+			if (vertex.tangent.SqrMagnitude() > 0.0f)
+			{
+				maxTangentAngle = std::max(maxTangentAngle, GetAngleDegrees({ decoded.tangentX, decoded.tangentY, decoded.tangentZ }, vertex.tangent));
+			}
+		}
+	}
+	size_t QuantizedVertexStreams::GetNrBytes() const
+	{
+		return m_UnsignedStorage.size() * sizeof(uint16_t) + m_SignedStorage.size() * sizeof(int16_t);
+	}
+
+	void VertexOutputStreams::Resize(const size_t nrVertices)
+	{
+		m_Capacity = 0;
+		size = 0;
+		Reserve(GetPaddedSize(nrVertices));
+		size = nrVertices;
+	}
+
+	void VertexOutputStreams::Clear()
+	{
+		size = 0;
+	}
+
+	uint32_t VertexOutputStreams::Add(const Vertex_Out& vertex, const Vector4& screenPosition)
+	{
+		if (size == m_Capacity)
+		{
+			Reserve(std::max<size_t>(2 * m_Capacity, 64));
+		}
+
+		const size_t index{ size++ };
+		pPositionX[index] = vertex.position.x;
+		pPositionY[index] = vertex.position.y;
+		pPositionZ[index] = vertex.position.z;
+		pPositionW[index] = vertex.position.w;
+		pScreenX[index] = screenPosition.x;
+		pScreenY[index] = screenPosition.y;
+		pDepth[index] = screenPosition.z;
+		pU[index] = vertex.uv.x;
+		pV[index] = vertex.uv.y;
+		pNormalX[index] = vertex.normal.x;
+		pNormalY[index] = vertex.normal.y;
+		pNormalZ[index] = vertex.normal.z;
+		pTangentX[index] = vertex.tangent.x;
+		pTangentY[index] = vertex.tangent.y;
+		pTangentZ[index] = vertex.tangent.z;
+		pViewX[index] = vertex.viewDirection.x;
+		pViewY[index] = vertex.viewDirection.y;
+		pViewZ[index] = vertex.viewDirection.z;
+		pOutsidePlanes[index] = Clipper::GetOutsidePlanes(vertex.position);
+
+		return static_cast<uint32_t>(index);
+	}
+
+	Vertex_Out VertexOutputStreams::GetVertex(const size_t index) const
+	{
+		return Vertex_Out
+		{
+			GetPosition(index),
+			ColorRGB{},
+			GetUV(index),
+			GetNormal(index),
+			GetTangent(index),
+			GetViewDirection(index)
+		};
+	}
+
+	void VertexOutputStreams::Reserve(const size_t capacity)
+	{
+		float** streams[m_NrStreams]
+		{
+			&pPositionX, &pPositionY, &pPositionZ, &pPositionW,
+			&pScreenX, &pScreenY, &pDepth,
+			&pU, &pV,
+			&pNormalX, &pNormalY, &pNormalZ,
+			&pTangentX, &pTangentY, &pTangentZ,
+			&pViewX, &pViewY, &pViewZ
+		};
+
+		std::vector<float> storage(m_NrStreams * capacity);
+		std::vector<uint8_t> outsidePlaneStorage(capacity);
+		for (int stream{ 0 }; stream < m_NrStreams; ++stream)
+		{
+			float* pNewStream{ storage.data() + stream * capacity };
+			if (size) std::copy_n(*streams[stream], size, pNewStream);
+			*streams[stream] = pNewStream;
+		}
+		if (size) std::copy_n(pOutsidePlanes, size, outsidePlaneStorage.data());
+		pOutsidePlanes = outsidePlaneStorage.data();
+
+		m_Storage = std::move(storage);
+		m_OutsidePlaneStorage = std::move(outsidePlaneStorage);
+		m_Capacity = capacity;
+	}
+
+	void VertexKernel::TransformConstants::Set(const Matrix& worldMatrix, const Matrix& viewProjectionMatrix, const Vector3& origin, const int screenWidth, const int screenHeight)
+	{
+		const Matrix worldViewProjectionMatrix{ worldMatrix * viewProjectionMatrix };
+		for (int row{ 0 }; row < 4; ++row)
+		{
+			for (int column{ 0 }; column < 4; ++column)
+			{
+				worldViewProjection[row][column] = worldViewProjectionMatrix[row][column];
+			}
+		}
+		for (int row{ 0 }; row < 3; ++row)
+		{
+			for (int column{ 0 }; column < 3; ++column)
+			{
+				world[row][column] = worldMatrix[row][column];
+			}
+		}
+
+		cameraOrigin[0] = origin.x;
+		cameraOrigin[1] = origin.y;
+		cameraOrigin[2] = origin.z;
+		width = static_cast<float>(screenWidth);
+		height = static_cast<float>(screenHeight);
+	}
+
+	VertexKernel::TransformFunction VertexKernel::GetTransformFunction(const PixelKernelType type)
+	{
+		switch (type)
+		{
+		case PixelKernelType::SSE:
+			return &TransformSSE;
+		case PixelKernelType::AVX2:
+			return &TransformAVX2;
+		default:
+			return &TransformScalar;
+		}
+	}
+
+	void VertexKernel::TransformScalar(const TransformConstants& constants, const VertexInputStreams& input, VertexOutputStreams& output, const size_t first, const size_t count)
+	{
+		TransformVertices<ScalarLanes>(constants, input, output, first, count);
+	}
+
+	void VertexKernel::TransformSSE(const TransformConstants& constants, const VertexInputStreams& input, VertexOutputStreams& output, const size_t first, const size_t count)
+	{
+		TransformVertices<SSELanes>(constants, input, output, first, count);
+	}
+
+	VertexKernel::TransformQuantizedFunction VertexKernel::GetTransformQuantizedFunction(const PixelKernelType type)
+	{
+		switch (type)
+		{
+		case PixelKernelType::SSE:
+			return &TransformQuantizedSSE;
+		case PixelKernelType::AVX2:
+			return &TransformQuantizedAVX2;
+		default:
+			return &TransformQuantizedScalar;
+		}
+	}
+
+	void VertexKernel::TransformQuantizedScalar(const TransformConstants& constants, const QuantizedVertexStreams& input, VertexOutputStreams& output, const size_t first, const size_t count)
+	{
+		TransformVertices<ScalarLanes>(constants, input, output, first, count);
+	}
+
+	void VertexKernel::TransformQuantizedSSE(const TransformConstants& constants, const QuantizedVertexStreams& input, VertexOutputStreams& output, const size_t first, const size_t count)
+	{
+		TransformVertices<SSELanes>(constants, input, output, first, count);
+	}
+}
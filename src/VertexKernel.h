@@ -0,0 +1,210 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "DataTypes.h"
+#include "PixelKernel.h"
+
+namespace dae
+{
+	//Vertices of a mesh as structure of arrays, one array per component, so the kernels load 8 vertices at once
+	//Every array is padded to a multiple of VertexKernel::padding with zeros
+	struct VertexInputStreams
+	{
+		VertexInputStreams() = default;
+		~VertexInputStreams() = default;
+
+		//Moving keeps the storage, so the pointers stay valid
+		VertexInputStreams(const VertexInputStreams&) = delete;
+		VertexInputStreams(VertexInputStreams&&) noexcept = default;
+		VertexInputStreams& operator=(const VertexInputStreams&) = delete;
+		VertexInputStreams& operator=(VertexInputStreams&&) noexcept = default;
+
+		void Assign(std::span<const Vertex> vertices);
+		size_t GetNrBytes() const;
+
+		const float* pPositionX{};
+		const float* pPositionY{};
+		const float* pPositionZ{};
+		const float* pNormalX{};
+		const float* pNormalY{};
+		const float* pNormalZ{};
+		const float* pTangentX{};
+		const float* pTangentY{};
+		const float* pTangentZ{};
+		const float* pU{};
+		const float* pV{};
+
+		size_t size{}; //Without the padding
+		size_t paddedSize{};
+
+	private:
+		static constexpr int m_NrStreams{ 11 };
+		std::vector<float> m_Storage{};
+	};
+
+	//Compressed copy of VertexInputStreams, 18 bytes per vertex instead of 44, decoded by the kernels while they load it
+	//Positions and uvs are 16 bit fixed point in the box of the mesh, normals and tangents 16 bit octahedral coordinates
+	//Padded like VertexInputStreams
+	struct QuantizedVertexStreams
+	{
+		QuantizedVertexStreams() = default;
+		~QuantizedVertexStreams() = default;
+
+		//Moving keeps the storage, so the pointers stay valid
+		QuantizedVertexStreams(const QuantizedVertexStreams&) = delete;
+		QuantizedVertexStreams(QuantizedVertexStreams&&) noexcept = default;
+		QuantizedVertexStreams& operator=(const QuantizedVertexStreams&) = delete;
+		QuantizedVertexStreams& operator=(QuantizedVertexStreams&&) noexcept = default;
+
+		//Also measures the errors below
+		void Assign(std::span<const Vertex> vertices);
+		size_t GetNrBytes() const;
+
+		//Octahedral coordinates of a unit vector in -1 to 1 are stored times this
+		static constexpr float octahedralRange{ 32767.0f };
+
+		//Decoded as offset + value * scale
+		const uint16_t* pPositionX{};
+		const uint16_t* pPositionY{};
+		const uint16_t* pPositionZ{};
+		const uint16_t* pU{};
+		const uint16_t* pV{};
+		float positionOffset[3]{};
+		float positionScale[3]{};
+		float uvOffset[2]{};
+		float uvScale[2]{};
+
+		//The vector before normalizing, see VertexKernelImpl.h
+		const int16_t* pNormalU{};
+		const int16_t* pNormalV{};
+		const int16_t* pTangentU{};
+		const int16_t* pTangentV{};
+
+		//Largest difference of the decoded vertices with the float ones
+		float maxPositionError{}; //Object space distance, at most half a step on every axis
+		float maxUVError{};
+		float maxNormalAngle{}; //Degrees, after normalizing
+		float maxTangentAngle{};
+
+		size_t size{}; //Without the padding
+		size_t paddedSize{};
+
+	private:
+		static constexpr int m_NrUnsignedStreams{ 5 };
+		static constexpr int m_NrSignedStreams{ 4 };
+		std::vector<uint16_t> m_UnsignedStorage{};
+		std::vector<int16_t> m_SignedStorage{};
+	};
+
+	//Streams the vertex stage reads, a mesh only keeps the ones of the selected format, see Scene::SetVertexFormat
+	enum struct VertexFormat
+	{
+		Float,
+		Quantized
+	};
+
+	//Output of the vertex stage, same layout as the input
+	//Also used for the vertices created by the clipping, those are added one by one
+	struct VertexOutputStreams
+	{
+		VertexOutputStreams() = default;
+		~VertexOutputStreams() = default;
+
+		VertexOutputStreams(const VertexOutputStreams&) = delete;
+		VertexOutputStreams(VertexOutputStreams&&) noexcept = default;
+		VertexOutputStreams& operator=(const VertexOutputStreams&) = delete;
+		VertexOutputStreams& operator=(VertexOutputStreams&&) noexcept = default;
+
+		//The content is lost
+		void Resize(size_t nrVertices);
+		//Keeps the memory for the next frame
+		void Clear();
+		//Grows the storage when needed, returns the index of the vertex
+		uint32_t Add(const Vertex_Out& vertex, const Vector4& screenPosition);
+
+		Vector4 GetPosition(const size_t index) const { return { pPositionX[index], pPositionY[index], pPositionZ[index], pPositionW[index] }; }
+		Vector4 GetScreenPosition(const size_t index) const { return { pScreenX[index], pScreenY[index], pDepth[index], pPositionW[index] }; }
+		Vector2 GetUV(const size_t index) const { return { pU[index], pV[index] }; }
+		Vector3 GetNormal(const size_t index) const { return { pNormalX[index], pNormalY[index], pNormalZ[index] }; }
+		Vector3 GetTangent(const size_t index) const { return { pTangentX[index], pTangentY[index], pTangentZ[index] }; }
+		Vector3 GetViewDirection(const size_t index) const { return { pViewX[index], pViewY[index], pViewZ[index] }; }
+		Vertex_Out GetVertex(size_t index) const;
+
+		//Clip space position
+		float* pPositionX{};
+		float* pPositionY{};
+		float* pPositionZ{};
+		float* pPositionW{};
+
+		//Screen space x and y, projected z
+		float* pScreenX{};
+		float* pScreenY{};
+		float* pDepth{};
+
+		float* pU{};
+		float* pV{};
+		float* pNormalX{};
+		float* pNormalY{};
+		float* pNormalZ{};
+		float* pTangentX{};
+		float* pTangentY{};
+		float* pTangentZ{};
+		float* pViewX{};
+		float* pViewY{};
+		float* pViewZ{};
+
+		uint8_t* pOutsidePlanes{}; //Clipper bits of the clip space position
+
+		size_t size{};
+
+	private:
+		static constexpr int m_NrStreams{ 18 };
+
+		//Moves the content to storage for capacity vertices
+		void Reserve(size_t capacity);
+
+		std::vector<float> m_Storage{};
+		std::vector<uint8_t> m_OutsidePlaneStorage{};
+		size_t m_Capacity{};
+	};
+
+	namespace VertexKernel
+	{
+		//The streams are padded so the kernels never have to handle a partial register
+		constexpr size_t padding{ 8 };
+
+		//Everything the kernels need about the instance and the camera
+		struct TransformConstants
+		{
+			float worldViewProjection[4][4]{};
+			float world[3][3]{}; //Rotation part, for the normals and tangents
+			float cameraOrigin[3]{};
+			float width{};
+			float height{};
+
+			void Set(const Matrix& worldMatrix, const Matrix& viewProjectionMatrix, const Vector3& origin, int screenWidth, int screenHeight);
+		};
+
+		//Transform the vertices [first, first + count[, first and count are multiples of padding
+		using TransformFunction = void(*)(const TransformConstants& constants, const VertexInputStreams& input, VertexOutputStreams& output, size_t first, size_t count);
+
+		//Every instruction set gives the same bits, the vertex kernel follows the selected pixel kernel
+		TransformFunction GetTransformFunction(PixelKernelType type);
+
+		void TransformScalar(const TransformConstants& constants, const VertexInputStreams& input, VertexOutputStreams& output, size_t first, size_t count);
+		void TransformSSE(const TransformConstants& constants, const VertexInputStreams& input, VertexOutputStreams& output, size_t first, size_t count);
+		void TransformAVX2(const TransformConstants& constants, const VertexInputStreams& input, VertexOutputStreams& output, size_t first, size_t count);
+
+		//Same output from the compressed vertices, the decoded values only differ from the float ones by the quantization
+		using TransformQuantizedFunction = void(*)(const TransformConstants& constants, const QuantizedVertexStreams& input, VertexOutputStreams& output, size_t first, size_t count);
+
+		TransformQuantizedFunction GetTransformQuantizedFunction(PixelKernelType type);
+
+		void TransformQuantizedScalar(const TransformConstants& constants, const QuantizedVertexStreams& input, VertexOutputStreams& output, size_t first, size_t count);
+		void TransformQuantizedSSE(const TransformConstants& constants, const QuantizedVertexStreams& input, VertexOutputStreams& output, size_t first, size_t count);
+		void TransformQuantizedAVX2(const TransformConstants& constants, const QuantizedVertexStreams& input, VertexOutputStreams& output, size_t first, size_t count);
+	}
+}
@@ -0,0 +1,24 @@
+//This file is compiled with AVX2 enabled (/arch:AVX2), only call it when PixelKernel::IsSupported says so
+//Only use intrinsics here, inline functions of other headers could end up compiled with AVX2 for the whole program
+
+//Project includes
+#include "VertexKernel.h"
+#include "VertexKernelImpl.h"
+#include "AVX2Lanes.h"
+
+namespace dae
+{
+	void VertexKernel::TransformAVX2(const TransformConstants& constants, const VertexInputStreams& input, VertexOutputStreams& output, const size_t first, const size_t count)
+	{
+		TransformVertices<AVX2Lanes>(constants, input, output, first, count);
+
+		//Avoid the penalty of switching back to the non VEX encoded code of the other files
+		_mm256_zeroupper();
+	}
+
+	void VertexKernel::TransformQuantizedAVX2(const TransformConstants& constants, const QuantizedVertexStreams& input, VertexOutputStreams& output, const size_t first, const size_t count)
+	{
+		TransformVertices<AVX2Lanes>(constants, input, output, first, count);
+		_mm256_zeroupper();
+	}
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+//Shared body of the vertex kernels, included by every instruction set translation unit
+//The operations are done in the same order for every Lanes type so all the kernels give the same bits
+
+#include "Clipper.h"
+#include "VertexKernel.h"
+
+namespace dae
+{
+	namespace
+	{
+		template<typename Lanes>
+		typename Lanes::Float TransformComponent(const typename Lanes::Float x, const typename Lanes::Float y, const typename Lanes::Float z, const float m0, const float m1, const float m2)
+		{
+			return Lanes::Add(Lanes::Add(Lanes::Mul(x, Lanes::Set1(m0)), Lanes::Mul(y, Lanes::Set1(m1))), Lanes::Mul(z, Lanes::Set1(m2)));
+		}
+
+		template<typename Lanes>
+		void StoreNormalized(const typename Lanes::Float x, const typename Lanes::Float y, const typename Lanes::Float z, float* pOutX, float* pOutY, float* pOutZ)
+		{
+			const typename Lanes::Float magnitude{ Lanes::Sqrt(Lanes::Add(Lanes::Add(Lanes::Mul(x, x), Lanes::Mul(y, y)), Lanes::Mul(z, z))) };
+
+			Lanes::Store(pOutX, Lanes::Div(x, magnitude));
+			Lanes::Store(pOutY, Lanes::Div(y, magnitude));
+			Lanes::Store(pOutZ, Lanes::Div(z, magnitude));
+		}
+
+		//Lanes::count vertices as the kernels use them, loaded from one of the input formats
+		template<typename Lanes>
+		struct InputVertices
+		{
+			typename Lanes::Float positionX;
+			typename Lanes::Float positionY;
+			typename Lanes::Float positionZ;
+			typename Lanes::Float u;
+			typename Lanes::Float v;
+			typename Lanes::Float normalX;
+			typename Lanes::Float normalY;
+			typename Lanes::Float normalZ;
+			typename Lanes::Float tangentX;
+			typename Lanes::Float tangentY;
+			typename Lanes::Float tangentZ;
+		};
+
+		template<typename Lanes>
+		InputVertices<Lanes> LoadVertices(const VertexInputStreams& input, const size_t i)
+		{
+			return InputVertices<Lanes>
+			{
+				Lanes::Load(input.pPositionX + i), Lanes::Load(input.pPositionY + i), Lanes::Load(input.pPositionZ + i),
+				Lanes::Load(input.pU + i), Lanes::Load(input.pV + i),
+				Lanes::Load(input.pNormalX + i), Lanes::Load(input.pNormalY + i), Lanes::Load(input.pNormalZ + i),
+				Lanes::Load(input.pTangentX + i), Lanes::Load(input.pTangentY + i), Lanes::Load(input.pTangentZ + i)
+			};
+		}
+
+		template<typename Lanes>
+		typename Lanes::Float Dequantize(const typename Lanes::Float value, const float offset, const float scale)
+		{
+			return Lanes::Add(Lanes::Set1(offset), Lanes::Mul(value, Lanes::Set1(scale)));
+		}
+
+		//Unfolds the octahedron, the lower half was folded over the diagonals of the upper one
+		//The result isn't normalized, the kernel does that after the transformation
+		template<typename Lanes>
+		void DecodeOctahedral(const int16_t* pU, const int16_t* pV, typename Lanes::Float& x, typename Lanes::Float& y, typename Lanes::Float& z)
+		{
+			using Float = typename Lanes::Float;
+
+			const Float zero{ Lanes::Set1(0.0f) };
+			const Float scale{ Lanes::Set1(1.0f / QuantizedVertexStreams::octahedralRange) };
+			const Float u{ Lanes::Mul(Lanes::LoadSigned16(pU), scale) };
+			const Float v{ Lanes::Mul(Lanes::LoadSigned16(pV), scale) };
+
+			z = Lanes::Sub(Lanes::Sub(Lanes::Set1(1.0f), Lanes::Abs(u)), Lanes::Abs(v));
+			const Float fold{ Lanes::Max(Lanes::Sub(zero, z), zero) };
+			x = Lanes::Sub(u, Lanes::CopySign(fold, u));
+			y = Lanes::Sub(v, Lanes::CopySign(fold, v));
+		}
+
+		template<typename Lanes>
+		InputVertices<Lanes> LoadVertices(const QuantizedVertexStreams& input, const size_t i)
+		{
+			InputVertices<Lanes> vertices{};
+			vertices.positionX = Dequantize<Lanes>(Lanes::LoadUnsigned16(input.pPositionX + i), input.positionOffset[0], input.positionScale[0]);
+			vertices.positionY = Dequantize<Lanes>(Lanes::LoadUnsigned16(input.pPositionY + i), input.positionOffset[1], input.positionScale[1]);
+			vertices.positionZ = Dequantize<Lanes>(Lanes::LoadUnsigned16(input.pPositionZ + i), input.positionOffset[2], input.positionScale[2]);
+			vertices.u = Dequantize<Lanes>(Lanes::LoadUnsigned16(input.pU + i), input.uvOffset[0], input.uvScale[0]);
+			vertices.v = Dequantize<Lanes>(Lanes::LoadUnsigned16(input.pV + i), input.uvOffset[1], input.uvScale[1]);
+			DecodeOctahedral<Lanes>(input.pNormalU + i, input.pNormalV + i, vertices.normalX, vertices.normalY, vertices.normalZ);
+			DecodeOctahedral<Lanes>(input.pTangentU + i, input.pTangentV + i, vertices.tangentX, vertices.tangentY, vertices.tangentZ);
+			return vertices;
+		}
+
+		//Input is VertexInputStreams or QuantizedVertexStreams
+		template<typename Lanes, typename Input>
+		void TransformVertices(const VertexKernel::TransformConstants& constants, const Input& input, VertexOutputStreams& output, const size_t first, const size_t count)
+		{
+			using Float = typename Lanes::Float;
+
+			const auto& m{ constants.worldViewProjection };
+			const auto& world{ constants.world };
+
+			const Float zero{ Lanes::Set1(0.0f) };
+			const Float one{ Lanes::Set1(1.0f) };
+			const Float two{ Lanes::Set1(2.0f) };
+			const Float guardBand{ Lanes::Set1(Clipper::guardBand) };
+
+			for (size_t i{ first }; i < first + count; i += Lanes::count)
+			{
+				const InputVertices<Lanes> vertices{ LoadVertices<Lanes>(input, i) };
+				const Float x{ vertices.positionX };
+				const Float y{ vertices.positionY };
+				const Float z{ vertices.positionZ };
+
+				//Clip space position, the points have w = 1
+				const Float clipX{ Lanes::Add(TransformComponent<Lanes>(x, y, z, m[0][0], m[1][0], m[2][0]), Lanes::Set1(m[3][0])) };
+				const Float clipY{ Lanes::Add(TransformComponent<Lanes>(x, y, z, m[0][1], m[1][1], m[2][1]), Lanes::Set1(m[3][1])) };
+				const Float clipZ{ Lanes::Add(TransformComponent<Lanes>(x, y, z, m[0][2], m[1][2], m[2][2]), Lanes::Set1(m[3][2])) };
+				const Float clipW{ Lanes::Add(TransformComponent<Lanes>(x, y, z, m[0][3], m[1][3], m[2][3]), Lanes::Set1(m[3][3])) };
+				Lanes::Store(output.pPositionX + i, clipX);
+				Lanes::Store(output.pPositionY + i, clipY);
+				Lanes::Store(output.pPositionZ + i, clipZ);
+				Lanes::Store(output.pPositionW + i, clipW);
+
+				//Perspective division and screen space, only valid for the vertices in front of the near plane
+				const Float ndcX{ Lanes::Div(clipX, clipW) };
+				const Float ndcY{ Lanes::Div(clipY, clipW) };
+				const Float ndcZ{ Lanes::Div(clipZ, clipW) };
+				Lanes::Store(output.pScreenX + i, Lanes::Mul(Lanes::Div(Lanes::Add(ndcX, one), two), Lanes::Set1(constants.width)));
+				Lanes::Store(output.pScreenY + i, Lanes::Mul(Lanes::Div(Lanes::Sub(one, ndcY), two), Lanes::Set1(constants.height)));
+				Lanes::Store(output.pDepth + i, ndcZ);
+
+				Lanes::Store(output.pU + i, vertices.u);
+				Lanes::Store(output.pV + i, vertices.v);
+
+				const Float normalX{ vertices.normalX };
+				const Float normalY{ vertices.normalY };
+				const Float normalZ{ vertices.normalZ };
+				StoreNormalized<Lanes>(
+					TransformComponent<Lanes>(normalX, normalY, normalZ, world[0][0], world[1][0], world[2][0]),
+					TransformComponent<Lanes>(normalX, normalY, normalZ, world[0][1], world[1][1], world[2][1]),
+					TransformComponent<Lanes>(normalX, normalY, normalZ, world[0][2], world[1][2], world[2][2]),
+					output.pNormalX + i, output.pNormalY + i, output.pNormalZ + i);
+
+				const Float tangentX{ vertices.tangentX };
+				const Float tangentY{ vertices.tangentY };
+				const Float tangentZ{ vertices.tangentZ };
+				StoreNormalized<Lanes>(
+					TransformComponent<Lanes>(tangentX, tangentY, tangentZ, world[0][0], world[1][0], world[2][0]),
+					TransformComponent<Lanes>(tangentX, tangentY, tangentZ, world[0][1], world[1][1], world[2][1]),
+					TransformComponent<Lanes>(tangentX, tangentY, tangentZ, world[0][2], world[1][2], world[2][2]),
+					output.pTangentX + i, output.pTangentY + i, output.pTangentZ + i);
+
+				//From the projected position, like the original per vertex code
+				StoreNormalized<Lanes>(
+					Lanes::Sub(ndcX, Lanes::Set1(constants.cameraOrigin[0])),
+					Lanes::Sub(ndcY, Lanes::Set1(constants.cameraOrigin[1])),
+					Lanes::Sub(ndcZ, Lanes::Set1(constants.cameraOrigin[2])),
+					output.pViewX + i, output.pViewY + i, output.pViewZ + i);
+
+				//Planes of Clipper::GetOutsidePlanes, one bit per lane
+				const Float negativeW{ Lanes::Sub(zero, clipW) };
+				const Float guardW{ Lanes::Mul(guardBand, clipW) };
+				const Float negativeGuardW{ Lanes::Sub(zero, guardW) };
+
+				const int left{ Lanes::MoveMask(Lanes::Less(clipX, negativeW)) };
+				const int right{ Lanes::MoveMask(Lanes::Greater(clipX, clipW)) };
+				const int bottom{ Lanes::MoveMask(Lanes::Less(clipY, negativeW)) };
+				const int top{ Lanes::MoveMask(Lanes::Greater(clipY, clipW)) };
+				const int nearPlane{ Lanes::MoveMask(Lanes::Less(clipZ, zero)) };
+				const int farPlane{ Lanes::MoveMask(Lanes::Greater(clipZ, clipW)) };
+				const int guard
+				{
+					Lanes::MoveMask(Lanes::Or(
+						Lanes::Or(Lanes::Less(clipX, negativeGuardW), Lanes::Greater(clipX, guardW)),
+						Lanes::Or(Lanes::Less(clipY, negativeGuardW), Lanes::Greater(clipY, guardW))))
+				};
+
+				for (int lane{ 0 }; lane < Lanes::count; ++lane)
+				{
+					const auto bit = [lane](const int mask, const uint8_t plane) { return static_cast<uint8_t>(((mask >> lane) & 1) * plane); };
+					output.pOutsidePlanes[i + lane] = bit(left, Clipper::outsideLeft) | bit(right, Clipper::outsideRight)
+						| bit(bottom, Clipper::outsideBottom) | bit(top, Clipper::outsideTop)
+						| bit(nearPlane, Clipper::outsideNear) | bit(farPlane, Clipper::outsideFar)
+						| bit(guard, Clipper::outsideGuardBand);
+				}
+			}
+		}
+	}
+}
@@ -5,25 +5,311 @@
 #undef main
 
 //Standard includes
+#include <chrono>
+#include <cmath>
 #include <iostream>
+#include <stdexcept>
+#include <string>
 
 //Project includes
 #include "Timer.h"
 #include "Renderer.h"
+#include "FrameWriter.h"
+#include "Benchmark.h"
 
 using namespace dae;
 
+//Longest sleep of the window loop while the frames don't change, an input ends it earlier
+constexpr int g_IdleWaitMs{ 16 };
+
+//Settings of an offline render, read from the command line
+struct HeadlessSettings
+{
+	int width{ 640 };
+	int height{ 480 };
+	int nrFrames{ 120 };
+	float framesPerSecond{ 30.0f }; //Time step of the scripted path
+	float rotationSpeed{ 1.0f }; //Radians per second
+	float cameraSpeed{ 0.0f }; //Units per second, towards the mesh
+	std::string outputDirectory{ "Frames" };
+	FrameFileFormat format{ FrameFileFormat::PPM };
+	bool writeFrames{ true };
+	bool isProfiling{ false }; //Print the stage times at the end
+	bool useVisibilityBuffer{ false };
+	bool useLevelOfDetail{ true };
+	ShadingRate shadingRate{ ShadingRate::Full };
+	bool compareShadingRates{ false }; //Print how far the coarse rates are from the full rate on the last frame
+	VertexFormat vertexFormat{ VertexFormat::Float };
+	bool compareVertexFormats{ false }; //Print how far the quantized vertices are from the float ones on the last frame
+	MathMode mathMode{ MathMode::Precise };
+	bool validateFastMath{ false }; //Check the errors of the fast math against their bounds before rendering
+	bool validateKernels{ false }; //Render the last frame again with every pixel kernel and compare it with the scalar one
+
+	bool isBenchmark{ false };
+	BenchmarkSettings benchmark{};
+
+	//Copies of the vehicle around the first one, to test big scenes, also used by the window mode
+	int nrVehicleCopies{ 0 };
+
+	//Window mode only, the render resolution drops while the frames take longer, 0 keeps the full resolution
+	float frameBudgetMs{ 1000.0f / 30.0f };
+};
+
 void ShutDown(SDL_Window* pWindow)
 {
 	SDL_DestroyWindow(pWindow);
 	SDL_Quit();
 }
 
+void PrintUsage()
+{
+	std::cout << "Usage: Rasterizer [--headless | --benchmark] [options]\n"
+		"  --width <pixels>, --height <pixels>, --frames <count>   greater than 0\n"
+		"  --fps <frames per second>                              greater than 0\n"
+		"  --rotation-speed <radians/s>, --camera-speed <units/s>\n"
+		"  --output <directory>, --format <ppm | rgba | none>\n"
+		"  --profile, --visibility-buffer, --no-lod\n"
+		"  --shading-rate <full | 2x2 | 4x4 | adaptive>, --shading-rate-report\n"
+		"  --quantized-vertices, --vertex-format-report\n"
+		"  --fast-math, --validate-fast-math, --validate-kernels\n"
+		"  --json <path>, --frame-budget <ms, 0 keeps the full resolution>, --vehicles <count>" << std::endl;
+}
+
+//The whole text has to be a number, "12abc" is rejected too
+bool ParseNumber(const std::string& text, int& value)
+{
+	try
+	{
+		size_t nrParsed{};
+		value = std::stoi(text, &nrParsed);
+		return nrParsed == text.size();
+	}
+	catch (const std::logic_error&) //invalid_argument and out_of_range
+	{
+		return false;
+	}
+}
+bool ParseNumber(const std::string& text, float& value)
+{
+	try
+	{
+		size_t nrParsed{};
+		value = std::stof(text, &nrParsed);
+		return nrParsed == text.size() && std::isfinite(value);
+	}
+	catch (const std::logic_error&)
+	{
+		return false;
+	}
+}
+
+enum struct ParseResult
+{
+	Window,
+	Headless,
+	Invalid //The error is printed, the program has to exit with a failure
+};
+
+ParseResult ParseHeadlessSettings(int argc, char* args[], HeadlessSettings& settings)
+{
+	bool isHeadless{ false };
+	bool hasFrames{ false };
+
+	for (int i{ 1 }; i < argc; ++i)
+	{
+		const std::string argument{ args[i] };
+
+		//Flags without a value
+		if (argument == "--headless")
+			isHeadless = true;
+		else if (argument == "--profile")
+			settings.isProfiling = true;
+		else if (argument == "--visibility-buffer")
+			settings.useVisibilityBuffer = true;
+		else if (argument == "--no-lod")
+			settings.useLevelOfDetail = false;
+		else if (argument == "--shading-rate-report")
+			settings.compareShadingRates = true;
+		else if (argument == "--quantized-vertices")
+			settings.vertexFormat = VertexFormat::Quantized;
+		else if (argument == "--vertex-format-report")
+			settings.compareVertexFormats = true;
+		else if (argument == "--fast-math")
+			settings.mathMode = MathMode::Fast;
+		else if (argument == "--validate-fast-math")
+			settings.validateFastMath = true;
+		else if (argument == "--validate-kernels")
+			settings.validateKernels = true;
+		else if (argument == "--benchmark")
+			settings.isBenchmark = true;
+		else
+		{
+			//Options with a value
+			if (i + 1 >= argc)
+			{
+				std::cout << "Missing value or unknown argument: " << argument << std::endl;
+				PrintUsage();
+				return ParseResult::Invalid;
+			}
+
+			const std::string value{ args[++i] };
+			bool isValid{ true };
+
+			if (argument == "--width")
+				isValid = ParseNumber(value, settings.width) && settings.width > 0;
+			else if (argument == "--height")
+				isValid = ParseNumber(value, settings.height) && settings.height > 0;
+			else if (argument == "--frames")
+			{
+				isValid = ParseNumber(value, settings.nrFrames) && settings.nrFrames > 0;
+				hasFrames = true;
+			}
+			else if (argument == "--fps")
+				isValid = ParseNumber(value, settings.framesPerSecond) && settings.framesPerSecond > 0.0f;
+			else if (argument == "--rotation-speed")
+				isValid = ParseNumber(value, settings.rotationSpeed);
+			else if (argument == "--camera-speed")
+				isValid = ParseNumber(value, settings.cameraSpeed);
+			else if (argument == "--output")
+				settings.outputDirectory = value;
+			else if (argument == "--format")
+			{
+				if (value == "ppm") settings.format = FrameFileFormat::PPM;
+				else if (value == "rgba") settings.format = FrameFileFormat::RGBA;
+				else isValid = value == "none";
+				settings.writeFrames = value != "none";
+			}
+			else if (argument == "--shading-rate")
+			{
+				if (value == "full") settings.shadingRate = ShadingRate::Full;
+				else if (value == "2x2") settings.shadingRate = ShadingRate::Coarse2x2;
+				else if (value == "4x4") settings.shadingRate = ShadingRate::Coarse4x4;
+				else if (value == "adaptive") settings.shadingRate = ShadingRate::Adaptive;
+				else isValid = false;
+			}
+			else if (argument == "--json")
+				settings.benchmark.outputPath = value;
+			else if (argument == "--frame-budget")
+				isValid = ParseNumber(value, settings.frameBudgetMs) && settings.frameBudgetMs >= 0.0f;
+			else if (argument == "--vehicles")
+				isValid = ParseNumber(value, settings.nrVehicleCopies) && settings.nrVehicleCopies >= 0;
+			else
+			{
+				std::cout << "Unknown argument: " << argument << std::endl;
+				PrintUsage();
+				return ParseResult::Invalid;
+			}
+
+			if (!isValid)
+			{
+				std::cout << "Invalid value for " << argument << ": " << value << std::endl;
+				PrintUsage();
+				return ParseResult::Invalid;
+			}
+		}
+	}
+
+	if (hasFrames)
+		settings.benchmark.nrFrames = settings.nrFrames;
+
+	return isHeadless || settings.isBenchmark ? ParseResult::Headless : ParseResult::Window;
+}
+
+//Render a fixed number of frames along a scripted path, without window
+int RunHeadless(const HeadlessSettings& settings)
+{
+	if (settings.validateFastMath && !FastMath::Validate(std::cout))
+		return 1;
+
+	const auto pRenderer = new Renderer(settings.width, settings.height);
+	const Vector3 cameraStart{ pRenderer->GetCameraOrigin() };
+	pRenderer->AddVehicleCopies(settings.nrVehicleCopies);
+
+	if (settings.useVisibilityBuffer)
+		pRenderer->ToggleVisibilityBuffer();
+	pRenderer->SetLevelOfDetail(settings.useLevelOfDetail);
+	pRenderer->SetShadingRate(settings.shadingRate);
+	pRenderer->SetVertexFormat(settings.vertexFormat);
+	pRenderer->SetMathMode(settings.mathMode);
+
+	if (settings.isProfiling)
+	{
+		pRenderer->GetProfiler().SetMaxFrames(settings.nrFrames);
+		pRenderer->GetProfiler().SetEnabled(true);
+	}
+
+	FrameWriter* pWriter{ nullptr };
+	if (settings.writeFrames)
+		pWriter = new FrameWriter(settings.outputDirectory, settings.format, settings.width, settings.height, pRenderer->GetBackBufferFormat());
+
+	const auto start{ std::chrono::steady_clock::now() };
+	for (int frame{ 0 }; frame < settings.nrFrames; ++frame)
+	{
+		//The path only depends on the frame number, so every run gives the same frames
+		const float time{ frame / settings.framesPerSecond };
+		pRenderer->SetMeshRotation(settings.rotationSpeed * time);
+		pRenderer->SetCameraOrigin(cameraStart + Vector3{ 0, 0, settings.cameraSpeed * time });
+
+		pRenderer->Render();
+
+		if (pWriter)
+			pWriter->Submit(pRenderer->GetBackBufferPixels());
+	}
+	const auto renderEnd{ std::chrono::steady_clock::now() };
+
+	//Waits for the frames still in the queue
+	bool hasFailed{ false };
+	if (pWriter)
+	{
+		hasFailed = pWriter->HasFailed();
+		delete pWriter;
+	}
+	const auto writeEnd{ std::chrono::steady_clock::now() };
+
+	const double renderSeconds{ std::chrono::duration<double>(renderEnd - start).count() };
+	const double totalSeconds{ std::chrono::duration<double>(writeEnd - start).count() };
+	std::cout << "Rendered " << settings.nrFrames << " frames at " << settings.width << "x" << settings.height
+		<< " in " << renderSeconds << "s (" << settings.nrFrames / renderSeconds << " fps), "
+		<< totalSeconds << "s including writing" << std::endl;
+
+	if (settings.isProfiling)
+	{
+		pRenderer->GetProfiler().PrintReport(std::cout);
+		pRenderer->PrintLevelsOfDetail(std::cout);
+	}
+
+	if (settings.compareShadingRates)
+		pRenderer->CompareShadingRates(std::cout);
+
+	if (settings.compareVertexFormats)
+		pRenderer->CompareVertexFormats(std::cout);
+
+	//Any color or depth bit that differs fails the run
+	if (settings.validateKernels)
+	{
+		const bool areKernelsValid{ pRenderer->ValidatePixelKernels() };
+		std::cout << (areKernelsValid ? "Pixel kernels match the scalar reference" : "Pixel kernels differ from the scalar reference") << std::endl;
+		hasFailed = hasFailed || !areKernelsValid;
+	}
+
+	delete pRenderer;
+	return hasFailed ? 1 : 0;
+}
+
 int main(int argc, char* args[])
 {
-	//Unreferenced parameters
-	(void)argc;
-	(void)args;
+	HeadlessSettings headlessSettings{};
+	const ParseResult parseResult{ ParseHeadlessSettings(argc, args, headlessSettings) };
+	if (parseResult == ParseResult::Invalid)
+		return 1;
+
+	if (parseResult == ParseResult::Headless)
+	{
+		if (headlessSettings.isBenchmark)
+			return RunBenchmark(headlessSettings.benchmark);
+
+		return RunHeadless(headlessSettings);
+	}
 
 	//Create window + surfaces
 	SDL_Init(SDL_INIT_VIDEO);
@@ -43,6 +329,8 @@ int main(int argc, char* args[])
 	//Initialize "framework"
 	const auto pTimer = new Timer();
 	const auto pRenderer = new Renderer(pWindow);
+	pRenderer->SetFrameBudget(headlessSettings.frameBudgetMs);
+	pRenderer->AddVehicleCopies(headlessSettings.nrVehicleCopies);
 
 	//Start loop
 	pTimer->Start();
@@ -70,6 +358,44 @@ int main(int argc, char* args[])
 				case SDL_SCANCODE_X:
 					takeScreenshot = true;
 					break;
+				case SDL_SCANCODE_R:
+					pRenderer->CycleShadingRate();
+					std::cout << "Shading rate: " << Renderer::GetShadingRateName(pRenderer->GetShadingRate()) << std::endl;
+					break;
+				case SDL_SCANCODE_L:
+					pRenderer->ToggleLevelOfDetail();
+					pRenderer->PrintLevelsOfDetail(std::cout);
+					break;
+				case SDL_SCANCODE_C:
+					pRenderer->CompareShadingRates(std::cout);
+					break;
+				case SDL_SCANCODE_Q:
+					pRenderer->ToggleVertexFormat();
+					std::cout << "Vertex format: " << Renderer::GetVertexFormatName(pRenderer->GetVertexFormat()) << std::endl;
+					break;
+				case SDL_SCANCODE_V:
+					pRenderer->CompareVertexFormats(std::cout);
+					break;
+				case SDL_SCANCODE_M:
+					pRenderer->ToggleMathMode();
+					std::cout << "Math mode: " << Renderer::GetMathModeName(pRenderer->GetMathMode()) << std::endl;
+					break;
+				case SDL_SCANCODE_P:
+					pRenderer->TogglePipelining();
+					std::cout << "Pipelined frames " << (pRenderer->IsPipeliningEnabled() ? "enabled" : "disabled") << std::endl;
+					break;
+				case SDL_SCANCODE_F1:
+					pRenderer->ToggleHierarchicalDepth();
+					std::cout << "Hierarchical depth " << (pRenderer->IsHierarchicalDepthEnabled() ? "enabled" : "disabled") << std::endl;
+					break;
+				case SDL_SCANCODE_F2:
+					pRenderer->ToggleBackFaceCulling();
+					std::cout << "Back-face culling " << (pRenderer->IsBackFaceCullingEnabled() ? "enabled" : "disabled") << std::endl;
+					break;
+				case SDL_SCANCODE_F3:
+					pRenderer->ToggleVisibilityBuffer();
+					std::cout << "Visibility buffer " << (pRenderer->IsVisibilityBufferEnabled() ? "enabled" : "disabled") << std::endl;
+					break;
 				case SDL_SCANCODE_F4:
 					pRenderer->ToggleDisplayZBuffer();
 					break;
@@ -82,6 +408,29 @@ int main(int argc, char* args[])
 				case SDL_SCANCODE_F7:
 					pRenderer->CycleShadingMode();
 					break;
+				case SDL_SCANCODE_F8:
+					pRenderer->CyclePixelKernel();
+					std::cout << "Pixel kernel: " << PixelKernel::GetName(pRenderer->GetPixelKernel()) << std::endl;
+					break;
+				case SDL_SCANCODE_F9:
+					//Same check as --validate-kernels
+					if (pRenderer->ValidatePixelKernels())
+						std::cout << "Pixel kernels match the scalar reference!" << std::endl;
+					else
+						std::cout << "Pixel kernels differ from the scalar reference!" << std::endl;
+					break;
+				case SDL_SCANCODE_F10:
+					pRenderer->ToggleProfiler();
+					std::cout << "Profiler " << (pRenderer->GetProfiler().IsEnabled() ? "enabled" : "disabled") << std::endl;
+					break;
+				case SDL_SCANCODE_F11:
+					pRenderer->ToggleTextureFilter();
+					std::cout << "Texture filter: " << (pRenderer->GetTextureFilter() == TextureFilter::Trilinear ? "trilinear" : "point") << std::endl;
+					break;
+				case SDL_SCANCODE_F12:
+					pRenderer->ToggleFrameReuse();
+					std::cout << "Frame reuse " << (pRenderer->IsFrameReuseEnabled() ? "enabled" : "disabled") << std::endl;
+					break;
 				}	
 				break;
 			}
@@ -93,13 +442,24 @@ int main(int argc, char* args[])
 		//--------- Render ---------
 		pRenderer->Render();
 
+		//Nothing changed on screen, sleep until the next input instead of spinning
+		if (pRenderer->WasFrameSkipped())
+			SDL_WaitEventTimeout(nullptr, g_IdleWaitMs);
+
 		//--------- Timer ---------
 		pTimer->Update();
 		printTimer += pTimer->GetElapsed();
 		if (printTimer >= 1.f)
 		{
 			printTimer = 0.f;
-			std::cout << "dFPS: " << pTimer->GetdFPS() << std::endl;
+			std::cout << "dFPS: " << pTimer->GetdFPS() << " (render scale " << pRenderer->GetRenderScale() << ")" << std::endl;
+
+			//Report of the last second
+			if (pRenderer->GetProfiler().IsEnabled())
+			{
+				pRenderer->GetProfiler().PrintReport(std::cout);
+				pRenderer->GetProfiler().Reset();
+			}
 		}
 
 		//Save screenshot after full render